@@ -0,0 +1,226 @@
+/**
+ * ConcurrentHashTable.cpp
+ * Sharded, thread-safe wrapper around HashTable
+ */
+#include "ConcurrentHashTable.h"
+#include <mutex>
+
+using namespace std;
+
+//----------------------------------------------------------------
+// ConcurrentHashTable (constructor): Creates the shards. The
+//             shard count is rounded up to a power of two, at most
+//             MAX_SHARDS. Shards always use MIX64, since the shard
+//             index is taken from hash bits LEGACY_SUM leaves at 0.
+//    Parameters:
+//       shardCount (size_t) - number of independent shards
+//       initCapacityPerShard (size_t) - initial buckets per shard
+//       resizeMode (ResizeMode) - how each shard grows
+//---------------------------------------------------------------
+ConcurrentHashTable::ConcurrentHashTable(size_t shardCount, size_t initCapacityPerShard, ResizeMode resizeMode) {
+    size_t count = 1;
+    while (count < shardCount && count < MAX_SHARDS) {
+        count *= 2;
+    }
+    this->shardCount = count;
+
+    shards = std::make_unique<Shard[]>(count);
+    for (size_t i = 0; i < count; i++) {
+        shards[i].table = HashTable(initCapacityPerShard, HashPolicy::MIX64, resizeMode);
+    }
+}
+
+//----------------------------------------------------------------
+// shardFor: Picks the shard for a hash.
+//    Returns:  the shard (Shard&)
+//    Parameters:
+//       hash (uint64_t) - MIX64 hash of the key
+//---------------------------------------------------------------
+ConcurrentHashTable::Shard& ConcurrentHashTable::shardFor(uint64_t hash) const {
+    return shards[(hash >> SHARD_SHIFT) & (shardCount - 1)];
+}
+
+//----------------------------------------------------------------
+// insert: Inserts a key value pair under the shard's write lock.
+//             Same rules as HashTable::insert().
+//    Returns:  true if inserted, false if duplicate or value is 9999 (bool)
+//    Parameters:
+//       key (string_view) - the key to insert
+//       value (size_t) - the value to associate with the key
+//---------------------------------------------------------------
+bool ConcurrentHashTable::insert(std::string_view key, size_t value) {
+    if (value == 9999) {
+        return false;
+    }
+
+    uint64_t hash = shards[0].table.hashKey(key);
+    Shard& shard = shardFor(hash);
+    unique_lock guard(shard.lock);
+
+    std::string keyCopy;
+    size_t bucketIdx = shard.table.prepareInsert(key, hash, keyCopy);
+    if (bucketIdx == SIZE_MAX) {
+        return false;
+    }
+    shard.table.fillBucket(bucketIdx, key, value, hash);
+    return true;
+}
+
+//----------------------------------------------------------------
+// remove: Removes a key under the shard's write lock.
+//    Returns:  true if removed, false if key not found (bool)
+//    Parameters:
+//       key (string_view) - the key to remove
+//---------------------------------------------------------------
+bool ConcurrentHashTable::remove(std::string_view key) {
+    uint64_t hash = shards[0].table.hashKey(key);
+    Shard& shard = shardFor(hash);
+    unique_lock guard(shard.lock);
+    return shard.table.removeHashed(key, hash);
+}
+
+//----------------------------------------------------------------
+// contains: Checks for a key under the shard's read lock (its
+//             write lock in HASHTABLE_STATS builds).
+//    Returns:  true if key in table, false otherwise (bool)
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+bool ConcurrentHashTable::contains(std::string_view key) const {
+    uint64_t hash = shards[0].table.hashKey(key);
+    Shard& shard = shardFor(hash);
+    LookupLock guard(shard.lock);
+    return shard.table.lookup(key, hash) != nullptr;
+}
+
+//----------------------------------------------------------------
+// get: Gets the value for a key under the shard's read lock (its
+//             write lock in HASHTABLE_STATS builds). The value is
+//             copied out, since a reference would outlive the lock.
+//    Returns:  value if found, std::nullopt if not found
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+std::optional<size_t> ConcurrentHashTable::get(std::string_view key) const {
+    uint64_t hash = shards[0].table.hashKey(key);
+    Shard& shard = shardFor(hash);
+    LookupLock guard(shard.lock);
+
+    const size_t* value = shard.table.lookup(key, hash);
+    if (value == nullptr) {
+        return std::nullopt;
+    }
+    return *value;
+}
+
+//----------------------------------------------------------------
+// assign: Replaces the value of an existing key under the shard's
+//             write lock. Stands in for operator[], which cannot
+//             hand out a reference safely.
+//    Returns:  true if the key was found, false otherwise (bool)
+//    Parameters:
+//       key (string_view) - the key to update
+//       value (size_t) - the new value
+//---------------------------------------------------------------
+bool ConcurrentHashTable::assign(std::string_view key, size_t value) {
+    uint64_t hash = shards[0].table.hashKey(key);
+    Shard& shard = shardFor(hash);
+    unique_lock guard(shard.lock);
+
+    const size_t* stored = shard.table.lookup(key, hash);
+    if (stored == nullptr) {
+        return false;
+    }
+    *const_cast<size_t*>(stored) = value;
+    return true;
+}
+
+//----------------------------------------------------------------
+// insertOrAssign: Sets the value of key, inserting it if missing,
+//             under the shard's write lock with one probe sequence.
+//    Returns:  true if key was inserted, false if assigned (bool)
+//    Parameters:
+//       key (string_view) - the key to set
+//       value (size_t) - the new value
+//---------------------------------------------------------------
+bool ConcurrentHashTable::insertOrAssign(std::string_view key, size_t value) {
+    uint64_t hash = shards[0].table.hashKey(key);
+    Shard& shard = shardFor(hash);
+    unique_lock guard(shard.lock);
+
+    bool inserted = false;
+    shard.table.findOrInsert(key, hash, value, inserted) = value;
+    return inserted;
+}
+
+//----------------------------------------------------------------
+// fetchAdd: Adds delta to the value of key, treating a missing key
+//             as 0, under the shard's write lock with one probe
+//             sequence.
+//    Returns:  the value before the add, 0 if key was new (size_t)
+//    Parameters:
+//       key (string_view) - the counter to update
+//       delta (size_t) - amount to add
+//---------------------------------------------------------------
+size_t ConcurrentHashTable::fetchAdd(std::string_view key, size_t delta) {
+    uint64_t hash = shards[0].table.hashKey(key);
+    Shard& shard = shardFor(hash);
+    unique_lock guard(shard.lock);
+
+    bool inserted = false;
+    size_t& stored = shard.table.findOrInsert(key, hash, 0, inserted);
+    size_t previous = stored;
+    stored += delta;
+    return previous;
+}
+
+//----------------------------------------------------------------
+// keys: Collects the keys of every shard, locking one shard at a
+//             time. Not a snapshot: writes to shards already read
+//             are not seen.
+//    Returns:  vector of all keys (vector<string>)
+//---------------------------------------------------------------
+std::vector<std::string> ConcurrentHashTable::keys() const {
+    std::vector<std::string> result;
+    for (size_t i = 0; i < shardCount; i++) {
+        shared_lock guard(shards[i].lock);
+        std::vector<std::string> shardKeys = shards[i].table.keys();
+        result.insert(result.end(), std::make_move_iterator(shardKeys.begin()),
+                      std::make_move_iterator(shardKeys.end()));
+    }
+    return result;
+}
+
+//----------------------------------------------------------------
+// size: Sums the shard sizes, locking one shard at a time.
+//    Returns:  number of key value pairs (size_t)
+//---------------------------------------------------------------
+size_t ConcurrentHashTable::size() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shardCount; i++) {
+        shared_lock guard(shards[i].lock);
+        total += shards[i].table.size();
+    }
+    return total;
+}
+
+//----------------------------------------------------------------
+// capacity: Sums the shard capacities.
+//    Returns:  total number of buckets (size_t)
+//---------------------------------------------------------------
+size_t ConcurrentHashTable::capacity() const {
+    size_t total = 0;
+    for (size_t i = 0; i < shardCount; i++) {
+        shared_lock guard(shards[i].lock);
+        total += shards[i].table.capacity();
+    }
+    return total;
+}
+
+//----------------------------------------------------------------
+// numShards: Returns the number of shards.
+//    Returns:  shard count (size_t)
+//---------------------------------------------------------------
+size_t ConcurrentHashTable::numShards() const {
+    return shardCount;
+}
@@ -0,0 +1,64 @@
+/**
+ * ConcurrentHashTable.h
+ *
+ * Thread-safe hash table built from independent HashTable shards.
+ * Each shard has its own reader-writer lock and resizes on its own,
+ * so a resize only blocks the keys that live in that shard.
+ */
+#ifndef CONCURRENTHASHTABLE_H
+#define CONCURRENTHASHTABLE_H
+
+#include "HashTable.h"
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+class ConcurrentHashTable {
+private:
+    // Shard is one HashTable and its lock, on its own cache lines so
+    // threads working in neighbouring shards do not share a line
+    struct alignas(64) Shard {
+        mutable std::shared_mutex lock;
+        HashTable table;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    size_t shardCount;
+
+    // The shard index comes from the hash bits just below the 7-bit
+    // control tag (bits 50-56), so every shard still sees full tags
+    static constexpr int SHARD_SHIFT = 50;
+    static constexpr size_t MAX_SHARDS = 128;
+
+    // A HASHTABLE_STATS build counts every lookup in the shard's
+    // HashTable counters, which readers would race on, so lookups
+    // take the shard's lock exclusively there
+#ifdef HASHTABLE_STATS
+    using LookupLock = std::unique_lock<std::shared_mutex>;
+#else
+    using LookupLock = std::shared_lock<std::shared_mutex>;
+#endif
+
+    Shard& shardFor(uint64_t hash) const;
+
+public:
+    static constexpr size_t DEFAULT_SHARDS = 16;
+
+    explicit ConcurrentHashTable(size_t shardCount = DEFAULT_SHARDS,
+                                 size_t initCapacityPerShard = HashTable::DEFAULT_INITIAL_CAPACITY,
+                                 ResizeMode resizeMode = ResizeMode::STOP_THE_WORLD);
+
+    bool insert(std::string_view key, size_t value);
+    bool remove(std::string_view key);
+    bool contains(std::string_view key) const;
+    std::optional<size_t> get(std::string_view key) const;
+    bool assign(std::string_view key, size_t value);
+    bool insertOrAssign(std::string_view key, size_t value);
+    size_t fetchAdd(std::string_view key, size_t delta);
+    std::vector<std::string> keys() const;
+    size_t size() const;
+    size_t capacity() const;
+    size_t numShards() const;
+};
+
+#endif
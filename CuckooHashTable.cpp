@@ -0,0 +1,964 @@
+/**
+ * CuckooHashTable.cpp
+ * Bucketized cuckoo hash table with a bounded lookup cost
+ */
+#include "CuckooHashTable.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+using namespace std;
+
+//----------------------------------------------------------------
+// CuckooHashTable (constructor): Creates an empty table with room
+//             for at least initCapacity keys. The bucket count is a
+//             power of two, at least 2, so buckets are picked with
+//             a mask.
+//    Parameters:
+//       initCapacity (size_t) - minimum number of slots
+//---------------------------------------------------------------
+CuckooHashTable::CuckooHashTable(size_t initCapacity) {
+    size_t bucketCount = std::bit_ceil(std::max<size_t>(2, (initCapacity + SLOTS - 1) / SLOTS));
+    buckets.assign(bucketCount, Bucket{});
+    keyBytes = 0;
+    deadKeyBytes = 0;
+    numElements = 0;
+    loadLimit = MAX_LOAD_FACTOR;
+}
+
+//----------------------------------------------------------------
+// tagOf: Takes the 16-bit tag of a hash from its top bits, which
+//             primaryBucket() does not use. 0 marks an empty slot,
+//             so it is mapped to 1.
+//    Returns:  tag in [1, 65535] (uint16_t)
+//    Parameters:
+//       hash (uint64_t) - full hash of the key
+//---------------------------------------------------------------
+uint16_t CuckooHashTable::tagOf(uint64_t hash) {
+    uint16_t tag = static_cast<uint16_t>(hash >> 48);
+    return tag == 0 ? 1 : tag;
+}
+
+//----------------------------------------------------------------
+// primaryBucket: Picks the first of a key's two buckets.
+//    Returns:  bucket index (size_t)
+//    Parameters:
+//       hash (uint64_t) - full hash of the key
+//---------------------------------------------------------------
+size_t CuckooHashTable::primaryBucket(uint64_t hash) const {
+    return hash & (buckets.size() - 1);
+}
+
+//----------------------------------------------------------------
+// alternateBucket: Finds the other bucket of a key from either of
+//             its buckets and its tag. XOR with a value derived
+//             from the tag undoes itself, so calling it on the
+//             result gives back the original bucket. The value is
+//             odd, so the two buckets always differ.
+//    Returns:  bucket index (size_t)
+//    Parameters:
+//       bucket (size_t) - one of the key's buckets
+//       tag (uint16_t) - tagOf() the key's hash
+//---------------------------------------------------------------
+size_t CuckooHashTable::alternateBucket(size_t bucket, uint16_t tag) const {
+    uint64_t offset = tag * 0xc6a4a7935bd1e995ULL;
+    offset ^= offset >> 32;
+    return (bucket ^ (offset | 1)) & (buckets.size() - 1);
+}
+
+//----------------------------------------------------------------
+// findSlot: Looks for a key in its two buckets. Only slots whose
+//             tag matches have their key record read.
+//    Returns:  slot index, SIZE_MAX if not in either bucket (size_t)
+//    Parameters:
+//       key (string_view) - the key to search for
+//       hash (uint64_t) - hashMix64(key)
+//       bucketIdx (size_t&) - set to the bucket holding the key
+//---------------------------------------------------------------
+size_t CuckooHashTable::findSlot(std::string_view key, uint64_t hash, size_t& bucketIdx) const {
+    uint16_t tag = tagOf(hash);
+    size_t first = primaryBucket(hash);
+    size_t candidates[2] = {first, alternateBucket(first, tag)};
+
+    for (size_t candidate : candidates) {
+        const Bucket& bucket = buckets[candidate];
+        for (size_t slot = 0; slot < SLOTS; slot++) {
+            if (bucket.tags[slot] != tag) {
+                continue;
+            }
+            if (keyMatches(bucket.keys[slot], key, hash)) {
+                bucketIdx = candidate;
+                return slot;
+            }
+        }
+    }
+    return SIZE_MAX;
+}
+
+//----------------------------------------------------------------
+// keyMatches: Compares a key with a record. The header and, for a
+//             key up to SHORT_KEY_BYTES, the key bytes are in the
+//             same cache line, so this reads one line.
+//    Returns:  true if the record holds key (bool)
+//    Parameters:
+//       keyRef (uint32_t) - record position, in KEY_ALIGN units
+//       key (string_view) - the key to compare
+//       hash (uint64_t) - hashMix64(key)
+//---------------------------------------------------------------
+bool CuckooHashTable::keyMatches(uint32_t keyRef, std::string_view key, uint64_t hash) const {
+    KeyHeader header = headerOf(keyRef);
+    return header.hash == hash && header.length == key.size() &&
+           std::memcmp(recordAt(keyRef) + sizeof(KeyHeader), key.data(), key.size()) == 0;
+}
+
+//----------------------------------------------------------------
+// findStash: Looks for a key in the stash.
+//    Returns:  stash index, SIZE_MAX if not there (size_t)
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+size_t CuckooHashTable::findStash(std::string_view key) const {
+    for (size_t i = 0; i < stash.size(); i++) {
+        if (keyOf(stash[i].key) == key) {
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+
+//----------------------------------------------------------------
+// findValue: Finds the value stored for a key.
+//    Returns:  pointer to the value, nullptr if not found
+//    Parameters:
+//       key (string_view) - the key to search for
+//       hash (uint64_t) - hashMix64(key)
+//---------------------------------------------------------------
+size_t* CuckooHashTable::findValue(std::string_view key, uint64_t hash) {
+    size_t bucketIdx = 0;
+    size_t slot = findSlot(key, hash, bucketIdx);
+    if (slot != SIZE_MAX) {
+        return &buckets[bucketIdx].values[slot];
+    }
+    size_t stashIdx = findStash(key);
+    return stashIdx != SIZE_MAX ? &stash[stashIdx].value : nullptr;
+}
+
+//----------------------------------------------------------------
+// placeInBucket: Puts a key in the first empty slot of a bucket.
+//    Returns:  true if the bucket had an empty slot (bool)
+//    Parameters:
+//       bucketIdx (size_t) - bucket to use
+//       tag (uint16_t) - tagOf() the key's hash
+//       keyRef (uint32_t) - arena record of the key
+//       value (size_t) - value to store
+//---------------------------------------------------------------
+bool CuckooHashTable::placeInBucket(size_t bucketIdx, uint16_t tag, uint32_t keyRef, size_t value) {
+    Bucket& bucket = buckets[bucketIdx];
+    for (size_t slot = 0; slot < SLOTS; slot++) {
+        if (bucket.tags[slot] == 0) {
+            bucket.tags[slot] = tag;
+            bucket.keys[slot] = keyRef;
+            bucket.values[slot] = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+//----------------------------------------------------------------
+// displace: Makes room for a key whose buckets are both full. A
+//             breadth-first search over the keys in those buckets,
+//             then the keys in their other buckets, and so on up to
+//             MAX_BFS_DEPTH moves, looks for a bucket with an empty
+//             slot. The shortest chain found is applied from its
+//             end: each key moves to its other bucket, into the
+//             slot the previous move freed, and the new key takes
+//             the last slot freed. A bucket is never used twice on
+//             one chain, so every move is still valid when it runs.
+//    Returns:  true if the key was placed (bool)
+//    Parameters:
+//       first (size_t) - the key's primary bucket
+//       second (size_t) - the key's alternate bucket
+//       tag (uint16_t) - tagOf() the key's hash
+//       keyRef (uint32_t) - arena record of the key
+//       value (size_t) - value to store
+//---------------------------------------------------------------
+bool CuckooHashTable::displace(size_t first, size_t second, uint16_t tag, uint32_t keyRef, size_t value) {
+    pathNodes.clear();
+    pathNodes.push_back({first, SIZE_MAX, 0, 0});
+    pathNodes.push_back({second, SIZE_MAX, 0, 0});
+
+    auto onPath = [this](size_t node, size_t bucket) {
+        for (; node != SIZE_MAX; node = pathNodes[node].parent) {
+            if (pathNodes[node].bucket == bucket) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (size_t n = 0; n < pathNodes.size(); n++) {
+        PathNode node = pathNodes[n];
+        const Bucket& bucket = buckets[node.bucket];
+
+        for (size_t slot = 0; slot < SLOTS; slot++) {
+            size_t target = alternateBucket(node.bucket, bucket.tags[slot]);
+            Bucket& targetBucket = buckets[target];
+            size_t freeSlot = std::find(targetBucket.tags, targetBucket.tags + SLOTS, 0) - targetBucket.tags;
+
+            if (freeSlot < SLOTS) {
+                // Apply the chain, last move first
+                size_t toBucket = target;
+                size_t toSlot = freeSlot;
+                size_t fromSlot = slot;
+                for (size_t cur = n; cur != SIZE_MAX; cur = pathNodes[cur].parent) {
+                    Bucket& from = buckets[pathNodes[cur].bucket];
+                    Bucket& to = buckets[toBucket];
+                    to.tags[toSlot] = from.tags[fromSlot];
+                    to.keys[toSlot] = from.keys[fromSlot];
+                    to.values[toSlot] = from.values[fromSlot];
+                    toBucket = pathNodes[cur].bucket;
+                    toSlot = fromSlot;
+                    fromSlot = pathNodes[cur].parentSlot;
+                }
+                Bucket& root = buckets[toBucket];
+                root.tags[toSlot] = tag;
+                root.keys[toSlot] = keyRef;
+                root.values[toSlot] = value;
+                return true;
+            }
+
+            if (node.depth + 1 < MAX_BFS_DEPTH && pathNodes.size() < MAX_BFS_NODES && !onPath(n, target)) {
+                pathNodes.push_back({target, n, slot, node.depth + 1});
+            }
+        }
+    }
+    return false;
+}
+
+//----------------------------------------------------------------
+// place: Stores a key that is known to be new: in an empty slot
+//             of either bucket, by displacing other keys, or in the
+//             stash.
+//    Returns:  true if placed, false if the table must grow (bool)
+//    Parameters:
+//       keyRef (uint32_t) - arena record of the key
+//       value (size_t) - value to store
+//---------------------------------------------------------------
+bool CuckooHashTable::place(uint32_t keyRef, size_t value) {
+    uint64_t hash = headerOf(keyRef).hash;
+    uint16_t tag = tagOf(hash);
+    size_t first = primaryBucket(hash);
+    size_t second = alternateBucket(first, tag);
+
+    if (placeInBucket(first, tag, keyRef, value) || placeInBucket(second, tag, keyRef, value) ||
+        displace(first, second, tag, keyRef, value)) {
+        return true;
+    }
+    if (stash.size() < STASH_SIZE) {
+        stash.push_back({keyRef, value});
+        return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------
+// rebuild: Places every key again in a new bucket array of the
+//             given size. Cached hashes are reused. If some key
+//             cannot be placed the old arrays are put back.
+//    Returns:  true if every key was placed (bool)
+//    Parameters:
+//       bucketCount (size_t) - buckets in the new array, a power of two
+//---------------------------------------------------------------
+bool CuckooHashTable::rebuild(size_t bucketCount) {
+    std::vector<Bucket> oldBuckets = std::move(buckets);
+    std::vector<StashEntry> oldStash = std::move(stash);
+    buckets.assign(bucketCount, Bucket{});
+    stash.clear();
+
+    bool placed = true;
+    for (const Bucket& bucket : oldBuckets) {
+        for (size_t slot = 0; slot < SLOTS && placed; slot++) {
+            if (bucket.tags[slot] != 0) {
+                placed = place(bucket.keys[slot], bucket.values[slot]);
+            }
+        }
+    }
+    for (const StashEntry& entry : oldStash) {
+        placed = placed && place(entry.key, entry.value);
+    }
+
+    if (!placed) {
+        buckets = std::move(oldBuckets);
+        stash = std::move(oldStash);
+    }
+    return placed;
+}
+
+//----------------------------------------------------------------
+// grow: Doubles the bucket count, as many times as it takes for
+//             every key to be placed.
+//    Returns:  void
+//---------------------------------------------------------------
+void CuckooHashTable::grow() {
+    size_t bucketCount = buckets.size() * 2;
+    while (!rebuild(bucketCount)) {
+        bucketCount *= 2;
+    }
+}
+
+//----------------------------------------------------------------
+// drainStash: Moves stashed keys into their buckets once a slot
+//             there is free again, so lookups stop checking them.
+//    Returns:  void
+//---------------------------------------------------------------
+void CuckooHashTable::drainStash() {
+    for (size_t i = 0; i < stash.size();) {
+        uint64_t hash = headerOf(stash[i].key).hash;
+        uint16_t tag = tagOf(hash);
+        size_t first = primaryBucket(hash);
+        if (placeInBucket(first, tag, stash[i].key, stash[i].value) ||
+            placeInBucket(alternateBucket(first, tag), tag, stash[i].key, stash[i].value)) {
+            stash.erase(stash.begin() + static_cast<ptrdiff_t>(i));
+        } else {
+            i++;
+        }
+    }
+}
+
+//----------------------------------------------------------------
+// storeKey: Appends a key record to the arena. A record that fits
+//             in a cache line and would cross into the next one
+//             starts on that next line instead, as does every
+//             longer record.
+//    Returns:  record position, in KEY_ALIGN units (uint32_t)
+//    Parameters:
+//       key (string_view) - the key to copy into the arena
+//       hash (uint64_t) - hashMix64(key)
+//---------------------------------------------------------------
+uint32_t CuckooHashTable::storeKey(std::string_view key, uint64_t hash) {
+    size_t recordBytes = sizeof(KeyHeader) + key.size();
+    size_t start = keyBytes;
+    if (start % sizeof(KeyLine) + recordBytes > sizeof(KeyLine)) {
+        start = (start + sizeof(KeyLine) - 1) / sizeof(KeyLine) * sizeof(KeyLine);
+    }
+    size_t end = start + recordBytes;
+    if (end > keyArena.size() * sizeof(KeyLine)) {
+        keyArena.resize((end + sizeof(KeyLine) - 1) / sizeof(KeyLine));
+    }
+
+    char* record = reinterpret_cast<char*>(keyArena.data()) + start;
+    KeyHeader header{hash, key.size()};
+    std::memcpy(record, &header, sizeof(header));
+    std::memcpy(record + sizeof(header), key.data(), key.size());
+    keyBytes = (end + KEY_ALIGN - 1) / KEY_ALIGN * KEY_ALIGN;
+    return static_cast<uint32_t>(start / KEY_ALIGN);
+}
+
+//----------------------------------------------------------------
+// releaseKey: Counts a removed key's record as dead, and compacts
+//             the arena once dead records are over half of it.
+//             Every record position may change.
+//    Returns:  void
+//    Parameters:
+//       keyRef (uint32_t) - record of the removed key
+//---------------------------------------------------------------
+void CuckooHashTable::releaseKey(uint32_t keyRef) {
+    size_t recordBytes = sizeof(KeyHeader) + headerOf(keyRef).length;
+    deadKeyBytes += (recordBytes + KEY_ALIGN - 1) / KEY_ALIGN * KEY_ALIGN;
+    if (deadKeyBytes * 2 > keyBytes) {
+        compactKeys();
+    }
+}
+
+//----------------------------------------------------------------
+// compactKeys: Copies the records of stored keys into a new arena,
+//             in bucket order, and points their slots and stash
+//             entries at the copies.
+//    Returns:  void
+//---------------------------------------------------------------
+void CuckooHashTable::compactKeys() {
+    std::vector<KeyLine> oldArena = std::move(keyArena);
+    keyArena.clear();
+    keyBytes = 0;
+    deadKeyBytes = 0;
+
+    auto copyRecord = [this, &oldArena](uint32_t& keyRef) {
+        const char* record = reinterpret_cast<const char*>(oldArena.data()) + static_cast<size_t>(keyRef) * KEY_ALIGN;
+        KeyHeader header;
+        std::memcpy(&header, record, sizeof(header));
+        keyRef = storeKey(std::string_view(record + sizeof(header), header.length), header.hash);
+    };
+    for (Bucket& bucket : buckets) {
+        for (size_t slot = 0; slot < SLOTS; slot++) {
+            if (bucket.tags[slot] != 0) {
+                copyRecord(bucket.keys[slot]);
+            }
+        }
+    }
+    for (StashEntry& entry : stash) {
+        copyRecord(entry.key);
+    }
+}
+
+//----------------------------------------------------------------
+// holds: Checks for a key in its buckets and the stash.
+//    Returns:  true if key in table (bool)
+//    Parameters:
+//       key (string_view) - the key to search for
+//       hash (uint64_t) - hashMix64(key)
+//---------------------------------------------------------------
+bool CuckooHashTable::holds(std::string_view key, uint64_t hash) const {
+    size_t bucketIdx = 0;
+    return findSlot(key, hash, bucketIdx) != SIZE_MAX || (!stash.empty() && findStash(key) != SIZE_MAX);
+}
+
+//----------------------------------------------------------------
+// insertNew: Stores a key known not to be in the table, growing
+//             first if it would pass a max load factor below 1.0,
+//             and then until it can be placed. At 1.0 the stash
+//             may hold keys past capacity(), as before.
+//    Returns:  void
+//    Parameters:
+//       key (string_view) - the key, copied into the key arena
+//       value (size_t) - the value to associate with the key
+//       hash (uint64_t) - hashMix64(key)
+//---------------------------------------------------------------
+void CuckooHashTable::insertNew(std::string_view key, size_t value, uint64_t hash) {
+    uint32_t keyRef = storeKey(key, hash);
+    double limit = loadLimit * static_cast<double>(capacity());
+    if (loadLimit < MAX_LOAD_FACTOR && static_cast<double>(numElements + 1) > limit) {
+        grow();
+    }
+    while (!place(keyRef, value)) {
+        grow();
+    }
+    numElements++;
+}
+
+//----------------------------------------------------------------
+// findOrInsert: Finds the value of key, inserting value for it if
+//             it is missing. A new key is looked up again once
+//             placed, since displacing other keys may have put it
+//             in either bucket.
+//    Returns:  reference to the key's value (size_t&)
+//    Parameters:
+//       key (string_view) - the key to find or insert
+//       hash (uint64_t) - hashMix64(key)
+//       value (size_t) - value for a new key
+//       inserted (bool&) - set to true if key was inserted
+//---------------------------------------------------------------
+size_t& CuckooHashTable::findOrInsert(std::string_view key, uint64_t hash, size_t value, bool& inserted) {
+    size_t* existing = findValue(key, hash);
+    inserted = existing == nullptr;
+    if (!inserted) {
+        return *existing;
+    }
+    insertNew(key, value, hash);
+    return *findValue(key, hash);
+}
+
+//----------------------------------------------------------------
+// insert: Inserts a key value pair into the table. Rejects
+//             duplicates and the reserved value 9999, like
+//             HashTable::insert().
+//    Returns:  true if successful, false if duplicate or value is 9999 (bool)
+//    Parameters:
+//       key (string_view) - the key to insert
+//       value (size_t) - the value to associate with the key
+//---------------------------------------------------------------
+bool CuckooHashTable::insert(std::string_view key, size_t value) {
+    if (value == 9999) {
+        return false;
+    }
+    uint64_t hash = hashMix64(key);
+    if (holds(key, hash)) {
+        return false;
+    }
+    insertNew(key, value, hash);
+    return true;
+}
+
+//----------------------------------------------------------------
+// insert (rvalue): Forwards to insert(string_view). Keys are
+//             copied into the key arena, so there is no storage
+//             to take over; the overload keeps the API of
+//             HashTable.
+//    Returns:  true if successful, false if duplicate or value is 9999 (bool)
+//    Parameters:
+//       key (string&&) - the key to insert
+//       value (size_t) - the value to associate with the key
+//---------------------------------------------------------------
+bool CuckooHashTable::insert(std::string&& key, size_t value) {
+    return insert(std::string_view(key), value);
+}
+
+//----------------------------------------------------------------
+// insert (C string): Forwards to insert(string_view).
+//    Returns:  true if successful, false if duplicate or value is 9999 (bool)
+//    Parameters:
+//       key (const char*) - the key to insert
+//       value (size_t) - the value to associate with the key
+//---------------------------------------------------------------
+bool CuckooHashTable::insert(const char* key, size_t value) {
+    return insert(std::string_view(key), value);
+}
+
+//----------------------------------------------------------------
+// remove: Removes a key value pair. The slot is simply emptied;
+//             cuckoo lookups never walk past it, so no tombstone
+//             is needed. A stashed key may then fit in a bucket.
+//             The key's record stays in the arena until
+//             compactKeys() runs.
+//    Returns:  true if removed, false if key not found (bool)
+//    Parameters:
+//       key (string_view) - the key to remove
+//---------------------------------------------------------------
+bool CuckooHashTable::remove(std::string_view key) {
+    uint64_t hash = hashMix64(key);
+    size_t bucketIdx = 0;
+    size_t slot = findSlot(key, hash, bucketIdx);
+    uint32_t keyRef = 0;
+
+    if (slot != SIZE_MAX) {
+        keyRef = buckets[bucketIdx].keys[slot];
+        buckets[bucketIdx].tags[slot] = 0;
+    } else {
+        size_t stashIdx = stash.empty() ? SIZE_MAX : findStash(key);
+        if (stashIdx == SIZE_MAX) {
+            return false;
+        }
+        keyRef = stash[stashIdx].key;
+        stash.erase(stash.begin() + static_cast<ptrdiff_t>(stashIdx));
+    }
+
+    releaseKey(keyRef);
+    numElements--;
+    if (!stash.empty()) {
+        drainStash();
+    }
+    return true;
+}
+
+//----------------------------------------------------------------
+// contains: Checks if a key exists in the table.
+//    Returns:  true if key in table, false otherwise (bool)
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+bool CuckooHashTable::contains(std::string_view key) const {
+    return holds(key, hashMix64(key));
+}
+
+//----------------------------------------------------------------
+// get: Gets the value associated with a key. Reads at most two
+//             buckets, plus the stash when it is not empty.
+//    Returns:  value if found, std::nullopt if not found
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+std::optional<size_t> CuckooHashTable::get(std::string_view key) const {
+    uint64_t hash = hashMix64(key);
+    size_t bucketIdx = 0;
+    size_t slot = findSlot(key, hash, bucketIdx);
+    if (slot != SIZE_MAX) {
+        return buckets[bucketIdx].values[slot];
+    }
+    if (!stash.empty()) {
+        size_t stashIdx = findStash(key);
+        if (stashIdx != SIZE_MAX) {
+            return stash[stashIdx].value;
+        }
+    }
+    return std::nullopt;
+}
+
+//----------------------------------------------------------------
+// operator[]: Bracket operator. Returns reference for reading
+//   Undefined behavior if key not in table.
+//    Returns:  reference to value (size_t&)
+//    Parameters:
+//       key (string_view) - the key to access
+//---------------------------------------------------------------
+size_t& CuckooHashTable::operator[](std::string_view key) {
+    return *findValue(key, hashMix64(key));
+}
+
+//----------------------------------------------------------------
+// insertOrAssign: Sets the value of key, inserting it if missing.
+//    Returns:  true if key was inserted, false if assigned (bool)
+//    Parameters:
+//       key (string_view) - the key to set
+//       value (size_t) - the new value
+//---------------------------------------------------------------
+bool CuckooHashTable::insertOrAssign(std::string_view key, size_t value) {
+    bool inserted = false;
+    findOrInsert(key, hashMix64(key), value, inserted) = value;
+    return inserted;
+}
+
+//----------------------------------------------------------------
+// tryEmplace: Inserts key with value if it is missing. An existing
+//             value is left alone.
+//    Returns:  reference to the key's value, and true if inserted
+//    Parameters:
+//       key (string_view) - the key to insert
+//       value (size_t) - value for a new key
+//---------------------------------------------------------------
+std::pair<size_t&, bool> CuckooHashTable::tryEmplace(std::string_view key, size_t value) {
+    bool inserted = false;
+    size_t& stored = findOrInsert(key, hashMix64(key), value, inserted);
+    return {stored, inserted};
+}
+
+//----------------------------------------------------------------
+// getOrInsert: Returns the value of key, inserting defaultValue
+//             first if key is missing. The reference is valid until
+//             the next insert or remove.
+//    Returns:  reference to the key's value (size_t&)
+//    Parameters:
+//       key (string_view) - the key to look up
+//       defaultValue (size_t) - value for a new key
+//---------------------------------------------------------------
+size_t& CuckooHashTable::getOrInsert(std::string_view key, size_t defaultValue) {
+    bool inserted = false;
+    return findOrInsert(key, hashMix64(key), defaultValue, inserted);
+}
+
+//----------------------------------------------------------------
+// fetchAdd: Adds delta to the value of key, treating a missing key
+//             as 0.
+//    Returns:  the value before the add, 0 if key was new (size_t)
+//    Parameters:
+//       key (string_view) - the counter to update
+//       delta (size_t) - amount to add
+//---------------------------------------------------------------
+size_t CuckooHashTable::fetchAdd(std::string_view key, size_t delta) {
+    bool inserted = false;
+    size_t& stored = findOrInsert(key, hashMix64(key), 0, inserted);
+    size_t previous = stored;
+    stored += delta;
+    return previous;
+}
+
+//----------------------------------------------------------------
+// keys: Returns a vector containing all keys currently stored
+//             in the table.
+//    Returns:  vector of all keys (vector<string>)
+//---------------------------------------------------------------
+std::vector<std::string> CuckooHashTable::keys() const {
+    std::vector<std::string> result;
+    result.reserve(numElements);
+    for (const Bucket& bucket : buckets) {
+        for (size_t slot = 0; slot < SLOTS; slot++) {
+            if (bucket.tags[slot] != 0) {
+                result.emplace_back(keyOf(bucket.keys[slot]));
+            }
+        }
+    }
+    for (const StashEntry& entry : stash) {
+        result.emplace_back(keyOf(entry.key));
+    }
+    return result;
+}
+
+//----------------------------------------------------------------
+// advanceEntry: Moves an iterator position to the next occupied
+//             slot, going from the last bucket into the stash. The
+//             end position is capacity() + stash.size().
+//    Returns:  void
+//    Parameters:
+//       index (size_t&) - position, updated
+//---------------------------------------------------------------
+void CuckooHashTable::advanceEntry(size_t& index) const {
+    size_t slots = capacity();
+    while (index < slots && buckets[index / SLOTS].tags[index % SLOTS] == 0) {
+        index++;
+    }
+}
+
+//----------------------------------------------------------------
+// iterator (constructor): Creates an iterator at an occupied slot
+//             or stash entry, or the end position.
+//    Parameters:
+//       table (CuckooHashTable*) - table iterated
+//       index (size_t) - position
+//---------------------------------------------------------------
+CuckooHashTable::iterator::iterator(CuckooHashTable* table, size_t index) : table(table), index(index) {}
+
+//----------------------------------------------------------------
+// operator* (iterator): Returns the pair at the current position.
+//    Returns:  (key, reference to value) pair
+//---------------------------------------------------------------
+CuckooHashTable::iterator::reference CuckooHashTable::iterator::operator*() const {
+    size_t slots = table->capacity();
+    if (index >= slots) {
+        StashEntry& entry = table->stash[index - slots];
+        return {table->keyOf(entry.key), entry.value};
+    }
+    Bucket& bucket = table->buckets[index / SLOTS];
+    return {table->keyOf(bucket.keys[index % SLOTS]), bucket.values[index % SLOTS]};
+}
+
+//----------------------------------------------------------------
+// operator++ (iterator): Moves to the next stored pair.
+//    Returns:  this iterator (iterator&)
+//---------------------------------------------------------------
+CuckooHashTable::iterator& CuckooHashTable::iterator::operator++() {
+    index++;
+    table->advanceEntry(index);
+    return *this;
+}
+
+CuckooHashTable::iterator CuckooHashTable::iterator::operator++(int) {
+    iterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+//----------------------------------------------------------------
+// const_iterator (constructor): Creates an iterator at an occupied
+//             slot or stash entry, or the end position.
+//    Parameters:
+//       table (const CuckooHashTable*) - table iterated
+//       index (size_t) - position
+//---------------------------------------------------------------
+CuckooHashTable::const_iterator::const_iterator(const CuckooHashTable* table, size_t index)
+    : table(table), index(index) {}
+
+//----------------------------------------------------------------
+// const_iterator (converting constructor): Makes a read-only
+//             iterator at the same position as a mutable one.
+//    Parameters:
+//       other (const iterator&) - iterator to copy
+//---------------------------------------------------------------
+CuckooHashTable::const_iterator::const_iterator(const iterator& other) : table(other.table), index(other.index) {}
+
+//----------------------------------------------------------------
+// operator* (const_iterator): Returns the pair at the current
+//             position.
+//    Returns:  (key, value) pair
+//---------------------------------------------------------------
+CuckooHashTable::const_iterator::reference CuckooHashTable::const_iterator::operator*() const {
+    size_t slots = table->capacity();
+    if (index >= slots) {
+        const StashEntry& entry = table->stash[index - slots];
+        return {table->keyOf(entry.key), entry.value};
+    }
+    const Bucket& bucket = table->buckets[index / SLOTS];
+    return {table->keyOf(bucket.keys[index % SLOTS]), bucket.values[index % SLOTS]};
+}
+
+//----------------------------------------------------------------
+// operator++ (const_iterator): Moves to the next stored pair.
+//    Returns:  this iterator (const_iterator&)
+//---------------------------------------------------------------
+CuckooHashTable::const_iterator& CuckooHashTable::const_iterator::operator++() {
+    index++;
+    table->advanceEntry(index);
+    return *this;
+}
+
+CuckooHashTable::const_iterator CuckooHashTable::const_iterator::operator++(int) {
+    const_iterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+//----------------------------------------------------------------
+// begin: Returns an iterator at the first stored pair.
+//    Returns:  iterator, equal to end() if the table is empty
+//---------------------------------------------------------------
+CuckooHashTable::iterator CuckooHashTable::begin() {
+    size_t index = 0;
+    advanceEntry(index);
+    return iterator(this, index);
+}
+
+//----------------------------------------------------------------
+// end: Returns the iterator past the last stored pair.
+//    Returns:  iterator
+//---------------------------------------------------------------
+CuckooHashTable::iterator CuckooHashTable::end() {
+    return iterator(this, capacity() + stash.size());
+}
+
+CuckooHashTable::const_iterator CuckooHashTable::begin() const {
+    return cbegin();
+}
+
+CuckooHashTable::const_iterator CuckooHashTable::end() const {
+    return cend();
+}
+
+//----------------------------------------------------------------
+// cbegin: Returns a read-only iterator at the first stored pair.
+//    Returns:  const_iterator, equal to cend() if the table is empty
+//---------------------------------------------------------------
+CuckooHashTable::const_iterator CuckooHashTable::cbegin() const {
+    size_t index = 0;
+    advanceEntry(index);
+    return const_iterator(this, index);
+}
+
+//----------------------------------------------------------------
+// cend: Returns the read-only iterator past the last stored pair.
+//    Returns:  const_iterator
+//---------------------------------------------------------------
+CuckooHashTable::const_iterator CuckooHashTable::cend() const {
+    return const_iterator(this, capacity() + stash.size());
+}
+
+//----------------------------------------------------------------
+// alpha: Calculates and returns the load factor (size/capacity).
+//    Returns:  load factor (double)
+//---------------------------------------------------------------
+double CuckooHashTable::alpha() const {
+    return static_cast<double>(numElements) / static_cast<double>(capacity());
+}
+
+//----------------------------------------------------------------
+// capacity: Returns the total number of slots in the table.
+//    Returns:  capacity (size_t)
+//---------------------------------------------------------------
+size_t CuckooHashTable::capacity() const {
+    return buckets.size() * SLOTS;
+}
+
+//----------------------------------------------------------------
+// size: Returns the number of key-value pairs currently stored.
+//    Returns:  size (size_t)
+//---------------------------------------------------------------
+size_t CuckooHashTable::size() const {
+    return numElements;
+}
+
+//----------------------------------------------------------------
+// clear: Removes every element but keeps the bucket count. The key
+//             arena is freed.
+//    Returns:  void
+//---------------------------------------------------------------
+void CuckooHashTable::clear() {
+    buckets.assign(buckets.size(), Bucket{});
+    stash.clear();
+    std::vector<KeyLine>().swap(keyArena);
+    keyBytes = 0;
+    deadKeyBytes = 0;
+    numElements = 0;
+}
+
+//----------------------------------------------------------------
+// minBucketsFor: Computes the fewest buckets, a power of two, that
+//             hold count elements at or below a load factor.
+//    Returns:  bucket count (size_t)
+//    Parameters:
+//       count (size_t) - number of elements
+//       loadFactor (double) - highest load factor allowed
+//---------------------------------------------------------------
+size_t CuckooHashTable::minBucketsFor(size_t count, double loadFactor) const {
+    size_t needed = static_cast<size_t>(static_cast<double>(count) / (SLOTS * loadFactor)) + 1;
+    return std::bit_ceil(std::max<size_t>(2, needed));
+}
+
+//----------------------------------------------------------------
+// reserve: Makes room for count elements at a load factor of
+//             about 0.9, which 4-slot buckets reach without
+//             failing, or the max load factor if that is lower, so
+//             inserting up to count keys rarely grows. Never
+//             shrinks the table.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of elements to make room for
+//---------------------------------------------------------------
+void CuckooHashTable::reserve(size_t count) {
+    size_t needed = minBucketsFor(count, std::min(0.9, loadLimit));
+    while (needed > buckets.size() && !rebuild(needed)) {
+        needed *= 2;
+    }
+}
+
+//----------------------------------------------------------------
+// rehash: Rebuilds the table with room for the given number of
+//             slots, or the fewest that keep the current elements
+//             below the max load factor if that is more. Can
+//             shrink the table. Doubles again if some key cannot be
+//             placed.
+//    Returns:  void
+//    Parameters:
+//       slots (size_t) - requested capacity
+//---------------------------------------------------------------
+void CuckooHashTable::rehash(size_t slots) {
+    size_t bucketCount = std::bit_ceil(std::max<size_t>(2, (slots + SLOTS - 1) / SLOTS));
+    bucketCount = std::max(bucketCount, minBucketsFor(numElements, loadLimit));
+    while (!rebuild(bucketCount)) {
+        bucketCount *= 2;
+    }
+}
+
+//----------------------------------------------------------------
+// maxLoadFactor: Returns the load factor the table grows at.
+//    Returns:  max load factor (double)
+//---------------------------------------------------------------
+double CuckooHashTable::maxLoadFactor() const {
+    return loadLimit;
+}
+
+//----------------------------------------------------------------
+// setMaxLoadFactor: Sets the load factor the table grows at,
+//             clamped to [MIN_LOAD_FACTOR, MAX_LOAD_FACTOR]. The
+//             default, 1.0, grows only when a key cannot be
+//             placed, which 4-slot buckets reach at about 0.95.
+//             Takes effect on the next insert.
+//    Returns:  void
+//    Parameters:
+//       loadFactor (double) - new max load factor
+//---------------------------------------------------------------
+void CuckooHashTable::setMaxLoadFactor(double loadFactor) {
+    loadLimit = std::clamp(loadFactor, MIN_LOAD_FACTOR, MAX_LOAD_FACTOR);
+}
+
+//----------------------------------------------------------------
+// stashSize: Returns how many keys are in the stash. Used for
+//             benchmarking; it is almost always 0.
+//    Returns:  number of stashed keys (size_t)
+//---------------------------------------------------------------
+size_t CuckooHashTable::stashSize() const {
+    return stash.size();
+}
+
+//----------------------------------------------------------------
+// printMe: Helper method that creates a string representation
+//             of the table showing all occupied slots.
+//    Returns:  string representation of table (string)
+//---------------------------------------------------------------
+std::string CuckooHashTable::printMe() const {
+    std::string result = "";
+
+    for (size_t i = 0; i < buckets.size(); i++) {
+        for (size_t slot = 0; slot < SLOTS; slot++) {
+            if (buckets[i].tags[slot] != 0) {
+                result += "Bucket " + std::to_string(i) + ": <" + std::string(keyOf(buckets[i].keys[slot])) +
+                          ", " + std::to_string(buckets[i].values[slot]) + ">\n";
+            }
+        }
+    }
+
+    for (const StashEntry& entry : stash) {
+        result += "Stash: <" + std::string(keyOf(entry.key)) + ", " + std::to_string(entry.value) + ">\n";
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------
+// operator<< (CuckooHashTable):  operator for printing the entire
+//             table by calling printMe().
+//    Returns:  output stream (ostream&)
+//    Parameters:
+//       os (ostream&) - output stream
+//       hashTable (CuckooHashTable&) - hash table to print
+//---------------------------------------------------------------
+std::ostream& operator<<(std::ostream& os, const CuckooHashTable& hashTable) {
+    os << hashTable.printMe();
+    return os;
+}
@@ -0,0 +1,293 @@
+/**
+ * CuckooHashTable.h
+ *
+ * Bucketized cuckoo hash table for paths that need a worst-case bound
+ * on lookups rather than an expected one. It has HashTable's core
+ * container API: insert, remove, lookups, the single-probe updates,
+ * iteration, reserve(), rehash() and the max load factor. Batch
+ * operations, buildFrom(), snapshots, stats, memory resources and the
+ * probe, growth and resize policies are HashTable only. Every key lives in one of exactly two buckets of four
+ * slots, or in a stash of at most STASH_SIZE entries. Keys live in
+ * one arena of cache-line-aligned records, and a record that fits in a
+ * line never crosses one. A lookup of a key up to SHORT_KEY_BYTES long
+ * therefore reads at most two 64-byte buckets plus one key line: the
+ * full key is compared only on a 16-bit tag match, and a second match
+ * in the same lookup is a tag collision (about 1 in 9000 lookups). A
+ * longer key costs one line per 64 bytes of its record. A non-empty
+ * stash adds the stash entries and their keys. Switching engines is a
+ * type alias where only that API is used:
+ *
+ *     using Table = CuckooHashTable;   // or HashTable
+ *
+ * The second bucket is derived from the first and the key's tag
+ * (partial-key cuckoo hashing), so a key can be moved to its other
+ * bucket without reading or hashing it again. An insert that finds
+ * both buckets full searches breadth-first, to a bounded depth, for a
+ * chain of moves that frees a slot. If there is none the key goes to
+ * the stash, and only when the stash is full does the table grow.
+ */
+#ifndef CUCKOOHASHTABLE_H
+#define CUCKOOHASHTABLE_H
+
+#include "HashTable.h"
+
+class CuckooHashTable {
+private:
+    static constexpr size_t SLOTS = 4;            // Slots per bucket
+    static constexpr size_t STASH_SIZE = 4;       // Keys that may live outside any bucket
+    static constexpr size_t MAX_BFS_DEPTH = 5;    // Longest chain of moves an insert tries
+    static constexpr size_t MAX_BFS_NODES = 2 * (1 + 4 + 16 + 64 + 256);
+
+    // Bucket holds four slots in one cache line. A tag of 0 marks an
+    // empty slot; keys[i] is where the key's record starts in
+    // keyArena, in units of KEY_ALIGN bytes.
+    struct alignas(64) Bucket {
+        uint16_t tags[SLOTS];
+        uint32_t keys[SLOTS];
+        size_t values[SLOTS];
+    };
+    static_assert(sizeof(Bucket) == 64, "cuckoo bucket must fill one cache line");
+
+    // KeyLine is one cache line of the key arena
+    struct alignas(64) KeyLine {
+        char bytes[64];
+    };
+
+    // KeyHeader starts each key record in the arena and is followed
+    // by the key's bytes. The hash is cached so growing never hashes
+    // a key again.
+    struct KeyHeader {
+        uint64_t hash;
+        uint64_t length;
+    };
+
+    static constexpr size_t KEY_ALIGN = 8;        // Records start on a multiple of this
+    static constexpr size_t SHORT_KEY_BYTES = sizeof(KeyLine) - sizeof(KeyHeader);
+
+    // StashEntry is a key that found no slot in either bucket
+    struct StashEntry {
+        uint32_t key;
+        size_t value;
+    };
+
+    // One bucket reached by the insert search, and how: the key in
+    // parent's bucket at parentSlot moves here
+    struct PathNode {
+        size_t bucket;
+        size_t parent;
+        size_t parentSlot;
+        size_t depth;
+    };
+
+    std::vector<Bucket> buckets;        // Power-of-two count
+    std::vector<KeyLine> keyArena;      // Key records, appended in insert order
+    size_t keyBytes;                    // Arena bytes used, including deadKeyBytes
+    size_t deadKeyBytes;                // Arena bytes of removed keys, reclaimed by compactKeys()
+    std::vector<StashEntry> stash;
+    std::vector<PathNode> pathNodes;    // Reused by displace() so inserts do not allocate
+    size_t numElements;
+    double loadLimit;                   // Grow once an insert would pass this load factor
+
+    //helpers
+    static uint16_t tagOf(uint64_t hash);
+    size_t primaryBucket(uint64_t hash) const;
+    size_t alternateBucket(size_t bucket, uint16_t tag) const;
+    size_t findSlot(std::string_view key, uint64_t hash, size_t& bucketIdx) const;
+    const char* recordAt(uint32_t keyRef) const;
+    KeyHeader headerOf(uint32_t keyRef) const;
+    std::string_view keyOf(uint32_t keyRef) const;
+    bool keyMatches(uint32_t keyRef, std::string_view key, uint64_t hash) const;
+    size_t findStash(std::string_view key) const;
+    size_t* findValue(std::string_view key, uint64_t hash);
+    bool place(uint32_t keyRef, size_t value);
+    bool placeInBucket(size_t bucketIdx, uint16_t tag, uint32_t keyRef, size_t value);
+    bool displace(size_t first, size_t second, uint16_t tag, uint32_t keyRef, size_t value);
+    bool rebuild(size_t bucketCount);
+    void grow();
+    void drainStash();
+    uint32_t storeKey(std::string_view key, uint64_t hash);
+    void releaseKey(uint32_t keyRef);
+    void compactKeys();
+    bool holds(std::string_view key, uint64_t hash) const;
+    void insertNew(std::string_view key, size_t value, uint64_t hash);
+    size_t& findOrInsert(std::string_view key, uint64_t hash, size_t value, bool& inserted);
+    size_t minBucketsFor(size_t count, double loadFactor) const;
+    void advanceEntry(size_t& index) const;
+
+public:
+    static constexpr size_t DEFAULT_INITIAL_CAPACITY = 8;
+    static constexpr double MIN_LOAD_FACTOR = 0.1;
+    static constexpr double MAX_LOAD_FACTOR = 1.0;   // Grow only when a key cannot be placed
+
+    // Iterators visit the buckets in order, then the stash. Any insert
+    // or remove invalidates them.
+    class iterator {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<std::string_view, size_t>;
+        using reference = std::pair<std::string_view, size_t&>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        reference operator*() const;
+        iterator& operator++();
+        iterator operator++(int);
+        bool operator==(const iterator& other) const = default;
+
+    private:
+        CuckooHashTable* table = nullptr;
+        size_t index = 0;   // Slot index over all buckets, then capacity() + stash index
+
+        iterator(CuckooHashTable* table, size_t index);
+        friend class CuckooHashTable;
+    };
+
+    class const_iterator {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<std::string_view, size_t>;
+        using reference = value_type;
+        using difference_type = std::ptrdiff_t;
+
+        const_iterator() = default;
+        const_iterator(const iterator& other);
+        reference operator*() const;
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        bool operator==(const const_iterator& other) const = default;
+
+    private:
+        const CuckooHashTable* table = nullptr;
+        size_t index = 0;
+
+        const_iterator(const CuckooHashTable* table, size_t index);
+        friend class CuckooHashTable;
+    };
+
+    CuckooHashTable(size_t initCapacity = DEFAULT_INITIAL_CAPACITY);
+    bool insert(std::string_view key, size_t value);
+    bool insert(std::string&& key, size_t value);
+    bool insert(const char* key, size_t value);
+    bool remove(std::string_view key);
+    bool contains(std::string_view key) const;
+    std::optional<size_t> get(std::string_view key) const;
+    size_t& operator[](std::string_view key);
+
+    // Single-probe updates, as in HashTable: any value may be stored
+    bool insertOrAssign(std::string_view key, size_t value);
+    std::pair<size_t&, bool> tryEmplace(std::string_view key, size_t value = 0);
+    size_t& getOrInsert(std::string_view key, size_t defaultValue = 0);
+    size_t fetchAdd(std::string_view key, size_t delta);
+    std::vector<std::string> keys() const;
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+
+    // Calls callback(string_view key, size_t& value) for every pair
+    template <typename Callback>
+    void forEach(Callback&& callback);
+    template <typename Callback>
+    void forEach(Callback&& callback) const;
+    double alpha() const;
+    size_t capacity() const;
+    size_t size() const;
+    void clear();
+    void reserve(size_t count);
+    void rehash(size_t slots);
+    double maxLoadFactor() const;
+    void setMaxLoadFactor(double loadFactor);
+    size_t stashSize() const;
+
+    std::string printMe() const;
+};
+
+//----------------------------------------------------------------
+// The record accessors are defined here so that forEach() and the
+// iterators can inline them.
+//---------------------------------------------------------------
+
+//----------------------------------------------------------------
+// recordAt: Finds the start of a key record in the arena.
+//    Returns:  pointer to the record's KeyHeader (const char*)
+//    Parameters:
+//       keyRef (uint32_t) - record position, in KEY_ALIGN units
+//---------------------------------------------------------------
+inline const char* CuckooHashTable::recordAt(uint32_t keyRef) const {
+    return reinterpret_cast<const char*>(keyArena.data()) + static_cast<size_t>(keyRef) * KEY_ALIGN;
+}
+
+//----------------------------------------------------------------
+// headerOf: Reads the header of a key record.
+//    Returns:  the key's hash and length (KeyHeader)
+//    Parameters:
+//       keyRef (uint32_t) - record position, in KEY_ALIGN units
+//---------------------------------------------------------------
+inline CuckooHashTable::KeyHeader CuckooHashTable::headerOf(uint32_t keyRef) const {
+    KeyHeader header;
+    std::memcpy(&header, recordAt(keyRef), sizeof(header));
+    return header;
+}
+
+//----------------------------------------------------------------
+// keyOf: Returns the key of a record. The view is valid until the
+//             next insert or remove.
+//    Returns:  key (string_view)
+//    Parameters:
+//       keyRef (uint32_t) - record position, in KEY_ALIGN units
+//---------------------------------------------------------------
+inline std::string_view CuckooHashTable::keyOf(uint32_t keyRef) const {
+    return std::string_view(recordAt(keyRef) + sizeof(KeyHeader), headerOf(keyRef).length);
+}
+
+//----------------------------------------------------------------
+// forEach: Calls callback(key, value) for every stored pair, bucket
+//             slots first and then the stash. The value is passed
+//             by reference so it can be updated in place. The
+//             callback must not insert or remove.
+//    Returns:  void
+//    Parameters:
+//       callback (Callback&&) - called as callback(string_view, size_t&)
+//---------------------------------------------------------------
+template <typename Callback>
+void CuckooHashTable::forEach(Callback&& callback) {
+    for (Bucket& bucket : buckets) {
+        for (size_t slot = 0; slot < SLOTS; slot++) {
+            if (bucket.tags[slot] != 0) {
+                callback(keyOf(bucket.keys[slot]), bucket.values[slot]);
+            }
+        }
+    }
+    for (StashEntry& entry : stash) {
+        callback(keyOf(entry.key), entry.value);
+    }
+}
+
+//----------------------------------------------------------------
+// forEach (const): Same as forEach(), with the value passed by
+//             value.
+//    Returns:  void
+//    Parameters:
+//       callback (Callback&&) - called as callback(string_view, size_t)
+//---------------------------------------------------------------
+template <typename Callback>
+void CuckooHashTable::forEach(Callback&& callback) const {
+    for (const Bucket& bucket : buckets) {
+        for (size_t slot = 0; slot < SLOTS; slot++) {
+            if (bucket.tags[slot] != 0) {
+                callback(keyOf(bucket.keys[slot]), bucket.values[slot]);
+            }
+        }
+    }
+    for (const StashEntry& entry : stash) {
+        callback(keyOf(entry.key), entry.value);
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const CuckooHashTable& hashTable);
+
+#endif
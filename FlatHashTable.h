@@ -0,0 +1,360 @@
+/**
+ * FlatHashTable.h
+ *
+ * Open addressing hash table for trivially copyable keys such as
+ * integer IDs. Keys and values are stored inline in one slot array,
+ * so no key ever needs a heap allocation. Uses the same control
+ * byte scheme as HashTable: one byte per slot that is empty,
+ * removed, or a 7-bit hash tag.
+ */
+#ifndef FLATHASHTABLE_H
+#define FLATHASHTABLE_H
+
+#include <vector>
+#include <optional>
+#include <memory>
+#include <functional>
+#include <type_traits>
+#include <cstdint>
+#include <cstddef>
+
+template <typename Key,
+          typename Value,
+          typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, Value>>>
+class FlatHashTable {
+    static_assert(std::is_trivially_copyable_v<Key>,
+                  "FlatHashTable stores keys inline; use HashTable for string keys");
+
+public:
+    // Slot holds one key value pair inline
+    struct Slot {
+        Key key;
+        Value value;
+    };
+
+private:
+    using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+    using ByteAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<uint8_t>;
+
+    std::vector<Slot, SlotAllocator> slots;
+    std::vector<uint8_t, ByteAllocator> control;   // CTRL_EMPTY, CTRL_DELETED or a 7-bit hash tag
+    size_t numElements;
+    size_t numRemoved;                             // CTRL_DELETED slots
+    Hash hasher;
+    KeyEqual equal;
+
+    static constexpr uint8_t CTRL_EMPTY = 0x80;
+    static constexpr uint8_t CTRL_DELETED = 0xFE;
+
+    //helpers
+    uint64_t hashKey(const Key& key) const;
+    static uint8_t controlTag(uint64_t hash);
+    size_t findBucket(const Key& key, uint64_t hash) const;
+    size_t findInsertBucket(const Key& key, uint64_t hash) const;
+    void resize(size_t newCapacity);
+
+public:
+    static constexpr size_t DEFAULT_INITIAL_CAPACITY = 8;
+
+    explicit FlatHashTable(size_t initCapacity = DEFAULT_INITIAL_CAPACITY,
+                           const Hash& hash = Hash(),
+                           const KeyEqual& keyEqual = KeyEqual(),
+                           const Allocator& alloc = Allocator());
+    bool insert(const Key& key, const Value& value);
+    bool remove(const Key& key);
+    bool contains(const Key& key) const;
+    std::optional<Value> get(const Key& key) const;
+    Value& operator[](const Key& key);
+    std::vector<Key> keys() const;
+    double alpha() const;
+    size_t capacity() const;
+    size_t size() const;
+};
+
+//----------------------------------------------------------------
+// FlatHashTable (constructor): Creates an empty table. The
+//             capacity is rounded up to a power of two so probing
+//             can mask instead of using %.
+//    Parameters:
+//       initCapacity (size_t) - minimum number of slots
+//       hash (Hash) - hash function for keys
+//       keyEqual (KeyEqual) - equality test for keys
+//       alloc (Allocator) - allocator for the slot and control arrays
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::FlatHashTable(size_t initCapacity,
+                                                                    const Hash& hash,
+                                                                    const KeyEqual& keyEqual,
+                                                                    const Allocator& alloc)
+    : slots(SlotAllocator(alloc)), control(ByteAllocator(alloc)), hasher(hash), equal(keyEqual) {
+    size_t cap = 1;
+    while (cap < initCapacity) {
+        cap *= 2;
+    }
+    slots.resize(cap);
+    control.assign(cap, CTRL_EMPTY);
+    numElements = 0;
+    numRemoved = 0;
+}
+
+//----------------------------------------------------------------
+// hashKey: Runs the user hash and then a 64-bit finalizer over
+//             it. std::hash is the identity for integers, which
+//             would leave the high bits (the control tag) at zero.
+//    Returns:  hash (uint64_t)
+//    Parameters:
+//       key (Key) - the key to hash
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+uint64_t FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::hashKey(const Key& key) const {
+    uint64_t h = static_cast<uint64_t>(hasher(key));
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+//----------------------------------------------------------------
+// controlTag: Top 7 bits of a hash, stored in the control byte.
+//    Returns:  tag in [0, 127] (uint8_t)
+//    Parameters:
+//       hash (uint64_t) - full hash of the key
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+uint8_t FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::controlTag(uint64_t hash) {
+    return static_cast<uint8_t>(hash >> 57);
+}
+
+//----------------------------------------------------------------
+// findBucket: Finds the slot holding key. Probes with triangular
+//             steps (1, 2, 3, ...) which visit every slot of a
+//             power-of-two table.
+//    Returns:  slot index if found, SIZE_MAX if not found (size_t)
+//    Parameters:
+//       key (Key) - the key to search for
+//       hash (uint64_t) - hashKey(key)
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+size_t FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::findBucket(const Key& key, uint64_t hash) const {
+    size_t mask = slots.size() - 1;
+    size_t probeIdx = hash & mask;
+    uint8_t tag = controlTag(hash);
+
+    for (size_t i = 1; i <= slots.size(); i++) {
+        uint8_t ctrl = control[probeIdx];
+        if (ctrl == tag && equal(slots[probeIdx].key, key)) {
+            return probeIdx;
+        }
+        if (ctrl == CTRL_EMPTY) {
+            break;
+        }
+        probeIdx = (probeIdx + i) & mask;
+    }
+    return SIZE_MAX;
+}
+
+//----------------------------------------------------------------
+// findInsertBucket: Finds a slot for a new key. Checks for
+//             duplicates up to the first empty slot, then reuses
+//             the first removed slot seen on the way if any.
+//    Returns:  slot index, SIZE_MAX if duplicate or full (size_t)
+//    Parameters:
+//       key (Key) - the key to insert
+//       hash (uint64_t) - hashKey(key)
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+size_t FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::findInsertBucket(const Key& key, uint64_t hash) const {
+    size_t mask = slots.size() - 1;
+    size_t probeIdx = hash & mask;
+    uint8_t tag = controlTag(hash);
+    size_t firstRemoved = SIZE_MAX;
+
+    for (size_t i = 1; i <= slots.size(); i++) {
+        uint8_t ctrl = control[probeIdx];
+        if (ctrl == tag && equal(slots[probeIdx].key, key)) {
+            return SIZE_MAX;
+        }
+        if (ctrl == CTRL_DELETED && firstRemoved == SIZE_MAX) {
+            firstRemoved = probeIdx;
+        }
+        if (ctrl == CTRL_EMPTY) {
+            return firstRemoved != SIZE_MAX ? firstRemoved : probeIdx;
+        }
+        probeIdx = (probeIdx + i) & mask;
+    }
+    return firstRemoved;
+}
+
+//----------------------------------------------------------------
+// resize: Re-places every key in a new slot array, dropping removed
+//             slots. Keys are known to be unique, so each one goes
+//             in the first empty slot of its probe sequence.
+//    Returns:  void
+//    Parameters:
+//       newCapacity (size_t) - slots in the new array, a power of two
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+void FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::resize(size_t newCapacity) {
+    std::vector<Slot, SlotAllocator> oldSlots = std::move(slots);
+    std::vector<uint8_t, ByteAllocator> oldControl = std::move(control);
+
+    numRemoved = 0;
+    size_t mask = newCapacity - 1;
+    slots = std::vector<Slot, SlotAllocator>(newCapacity, oldSlots.get_allocator());
+    control = std::vector<uint8_t, ByteAllocator>(newCapacity, CTRL_EMPTY, oldControl.get_allocator());
+
+    for (size_t i = 0; i < oldSlots.size(); i++) {
+        if (oldControl[i] >= CTRL_EMPTY) {
+            continue;
+        }
+        uint64_t hash = hashKey(oldSlots[i].key);
+        size_t probeIdx = hash & mask;
+        for (size_t step = 1; control[probeIdx] != CTRL_EMPTY; step++) {
+            probeIdx = (probeIdx + step) & mask;
+        }
+        slots[probeIdx] = std::move(oldSlots[i]);
+        control[probeIdx] = controlTag(hash);
+    }
+}
+
+//----------------------------------------------------------------
+// insert: Inserts a key value pair. Once live plus removed slots
+//             reach half the capacity the table is rebuilt: at
+//             double the size, or at the same size if removed slots
+//             make up most of that half, so churn cannot fill the
+//             table with removed slots. A duplicate is found first,
+//             so it never triggers a rebuild.
+//    Returns:  true if inserted, false if key already present (bool)
+//    Parameters:
+//       key (Key) - the key to insert
+//       value (Value) - the value to associate with the key
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::insert(const Key& key, const Value& value) {
+    uint64_t hash = hashKey(key);
+    size_t bucketIdx = findInsertBucket(key, hash);
+    if (bucketIdx == SIZE_MAX) {
+        return false;
+    }
+
+    size_t cap = slots.size();
+    if ((numElements + numRemoved + 1) * 2 > cap) {
+        resize((numElements + 1) * 4 > cap ? cap * 2 : cap);
+        bucketIdx = findInsertBucket(key, hash);
+    }
+
+    if (control[bucketIdx] == CTRL_DELETED) {
+        numRemoved--;
+    }
+    slots[bucketIdx].key = key;
+    slots[bucketIdx].value = value;
+    control[bucketIdx] = controlTag(hash);
+    numElements++;
+    return true;
+}
+
+//----------------------------------------------------------------
+// remove: Removes a key by marking its slot as removed.
+//    Returns:  true if removed, false if key not found (bool)
+//    Parameters:
+//       key (Key) - the key to remove
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::remove(const Key& key) {
+    size_t bucketIdx = findBucket(key, hashKey(key));
+    if (bucketIdx == SIZE_MAX) {
+        return false;
+    }
+
+    control[bucketIdx] = CTRL_DELETED;
+    numElements--;
+    numRemoved++;
+    return true;
+}
+
+//----------------------------------------------------------------
+// contains: Checks if a key exists in the table.
+//    Returns:  true if key in table, false otherwise (bool)
+//    Parameters:
+//       key (Key) - the key to search for
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+bool FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::contains(const Key& key) const {
+    return findBucket(key, hashKey(key)) != SIZE_MAX;
+}
+
+//----------------------------------------------------------------
+// get: Gets the value associated with a key.
+//    Returns:  value if found, std::nullopt if not found
+//    Parameters:
+//       key (Key) - the key to search for
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::optional<Value> FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::get(const Key& key) const {
+    size_t bucketIdx = findBucket(key, hashKey(key));
+    if (bucketIdx == SIZE_MAX) {
+        return std::nullopt;
+    }
+    return slots[bucketIdx].value;
+}
+
+//----------------------------------------------------------------
+// operator[]: Returns a reference to the value for key.
+//   Undefined behavior if key not in table, same as HashTable.
+//    Returns:  reference to value (Value&)
+//    Parameters:
+//       key (Key) - the key to access
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+Value& FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::operator[](const Key& key) {
+    return slots[findBucket(key, hashKey(key))].value;
+}
+
+//----------------------------------------------------------------
+// keys: Returns all keys currently stored in the table.
+//    Returns:  vector of all keys (vector<Key>)
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+std::vector<Key> FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::keys() const {
+    std::vector<Key> result;
+    result.reserve(numElements);
+    for (size_t i = 0; i < slots.size(); i++) {
+        if (control[i] < CTRL_EMPTY) {
+            result.push_back(slots[i].key);
+        }
+    }
+    return result;
+}
+
+//----------------------------------------------------------------
+// alpha: Returns the load factor (size/capacity).
+//    Returns:  load factor (double)
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+double FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::alpha() const {
+    return static_cast<double>(numElements) / static_cast<double>(slots.size());
+}
+
+//----------------------------------------------------------------
+// capacity: Returns the total number of slots in the table.
+//    Returns:  capacity (size_t)
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+size_t FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::capacity() const {
+    return slots.size();
+}
+
+//----------------------------------------------------------------
+// size: Returns the number of key value pairs stored.
+//    Returns:  size (size_t)
+//---------------------------------------------------------------
+template <typename Key, typename Value, typename Hash, typename KeyEqual, typename Allocator>
+size_t FlatHashTable<Key, Value, Hash, KeyEqual, Allocator>::size() const {
+    return numElements;
+}
+
+#endif
@@ -0,0 +1,310 @@
+/**
+ * FrozenHashTable.cpp
+ * Read-only table placed with a minimal perfect hash
+ */
+#include "FrozenHashTable.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+//----------------------------------------------------------------
+// FrozenHashTable (constructor): Builds a frozen copy of a table.
+//             Keys are copied once into the arena. Cached hashes are
+//             reused when the table already hashes with MIX64.
+//             Elements still in the old array of an incremental
+//             resize are included.
+//    Parameters:
+//       table (const HashTable&) - table to copy
+//---------------------------------------------------------------
+FrozenHashTable::FrozenHashTable(const HashTable& table) {
+    std::vector<Item> items;
+    items.reserve(table.size());
+
+    auto collect = [&](const std::pmr::vector<HashTableBucket>& data, const std::pmr::vector<size_t>& values,
+                       const std::pmr::vector<uint8_t>& ctrl) {
+        for (size_t i = 0; i < data.size(); i++) {
+            if (ctrl[i] >= HashTable::CTRL_EMPTY) {
+                continue;
+            }
+            std::string_view key = table.keyOf(data[i]);
+            uint64_t hash = table.policy == HashPolicy::MIX64 ? data[i].hash : hashMix64(key);
+            items.emplace_back(hash, std::make_pair(key, values[i]));
+        }
+    };
+    collect(table.tableData, table.valueData, table.control);
+    collect(table.oldData, table.oldValues, table.oldControl);
+
+    build(items);
+}
+
+//----------------------------------------------------------------
+// groupOf: Picks the group a hash belongs to.
+//    Returns:  group index (size_t)
+//    Parameters:
+//       hash (uint64_t) - MIX64 hash of the key
+//---------------------------------------------------------------
+size_t FrozenHashTable::groupOf(uint64_t hash) const {
+    return hash % pilots.size();
+}
+
+//----------------------------------------------------------------
+// positionOf: Maps a hash and its group's pilot to a position in
+//             [0, positionRange). The pilot is mixed in and the
+//             result finalized, so each pilot gives the group an
+//             unrelated set of positions to try.
+//    Returns:  position (size_t)
+//    Parameters:
+//       hash (uint64_t) - MIX64 hash of the key
+//       pilot (uint32_t) - pilot of the key's group
+//---------------------------------------------------------------
+size_t FrozenHashTable::positionOf(uint64_t hash, uint32_t pilot) const {
+    uint64_t x = hash ^ (static_cast<uint64_t>(pilot) * 0x9E3779B97F4A7C15ULL);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x % positionRange;
+}
+
+//----------------------------------------------------------------
+// fingerprintOf: Takes the fingerprint bits of keyRef from a hash.
+//             Uses the top byte, which positionOf() does not favor.
+//    Returns:  fingerprint, already shifted into place (uint64_t)
+//    Parameters:
+//       hash (uint64_t) - MIX64 hash of the key
+//---------------------------------------------------------------
+uint64_t FrozenHashTable::fingerprintOf(uint64_t hash) {
+    return (hash >> 56) << FINGERPRINT_SHIFT;
+}
+
+//----------------------------------------------------------------
+// keyOf: Returns the key of an entry.
+//    Returns:  key (string_view)
+//    Parameters:
+//       entry (const Entry&) - entry to read
+//---------------------------------------------------------------
+std::string_view FrozenHashTable::keyOf(const Entry& entry) const {
+    return std::string_view(arena.data() + (entry.keyRef >> OFFSET_SHIFT), entry.keyRef & KEY_LENGTH_MASK);
+}
+
+//----------------------------------------------------------------
+// build: Places every item. Groups are filled largest first, each
+//             trying pilots 0, 1, 2, ... until all of its keys land
+//             on distinct free positions. Positions at or past n,
+//             which exist because the range is n / SLOT_LOAD, are
+//             then remapped onto the slots below n left free.
+//    Returns:  void
+//    Parameters:
+//       items (vector) - full hash, key and value of every key
+//---------------------------------------------------------------
+void FrozenHashTable::build(std::vector<Item>& items) {
+    size_t n = items.size();
+    size_t groupCount = std::max<size_t>(1, static_cast<size_t>(std::ceil(n / KEYS_PER_GROUP)));
+    pilots.assign(groupCount, 0);
+
+    // Counting sort by group, then sort each (small) group by hash
+    std::vector<size_t> groupStart(groupCount + 1, 0);
+    for (const auto& item : items) {
+        groupStart[groupOf(item.first) + 1]++;
+    }
+    for (size_t g = 0; g < groupCount; g++) {
+        groupStart[g + 1] += groupStart[g];
+    }
+    {
+        std::vector<Item> grouped(n);
+        std::vector<size_t> cursor(groupStart.begin(), groupStart.end() - 1);
+        for (const auto& item : items) {
+            grouped[cursor[groupOf(item.first)]++] = item;
+        }
+        items.swap(grouped);
+    }
+    for (size_t g = 0; g < groupCount; g++) {
+        std::sort(items.begin() + groupStart[g], items.begin() + groupStart[g + 1]);
+    }
+
+    // Set aside keys no pilot can place: a repeated full hash, or a
+    // key too long for an entry's length field. Equal hashes are in
+    // the same group, so they are adjacent after the sort.
+    std::vector<Item> placeable;
+    placeable.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        auto [key, value] = items[i].second;
+        bool repeatedHash = !placeable.empty() && placeable.back().first == items[i].first;
+        if (repeatedHash || key.size() > KEY_LENGTH_MASK) {
+            overflow.emplace_back(std::string(key), value);
+        } else {
+            placeable.push_back(items[i]);
+        }
+    }
+    items.clear();
+    items.shrink_to_fit();
+
+    size_t slots = placeable.size();
+    if (slots == 0) {
+        return;
+    }
+    positionRange = std::max(slots, static_cast<size_t>(std::ceil(slots / SLOT_LOAD)));
+
+    // Group boundaries without the set-aside keys, then groups ordered
+    // largest first
+    std::fill(groupStart.begin(), groupStart.end(), 0);
+    for (const auto& item : placeable) {
+        groupStart[groupOf(item.first) + 1]++;
+    }
+    for (size_t g = 0; g < groupCount; g++) {
+        groupStart[g + 1] += groupStart[g];
+    }
+    std::vector<size_t> order(groupCount);
+    for (size_t g = 0; g < groupCount; g++) {
+        order[g] = g;
+    }
+    std::stable_sort(order.begin(), order.end(), [&groupStart](size_t a, size_t b) {
+        return groupStart[a + 1] - groupStart[a] > groupStart[b + 1] - groupStart[b];
+    });
+
+    std::vector<uint8_t> taken(positionRange, 0);
+    std::vector<size_t> positionOfItem(slots);
+    std::vector<size_t> tried;
+    for (size_t g : order) {
+        size_t first = groupStart[g];
+        size_t last = groupStart[g + 1];
+        if (first == last) {
+            break;
+        }
+
+        for (uint32_t pilot = 0; ; pilot++) {
+            tried.clear();
+            bool fits = true;
+            for (size_t i = first; i < last && fits; i++) {
+                size_t position = positionOf(placeable[i].first, pilot);
+                fits = !taken[position] && std::find(tried.begin(), tried.end(), position) == tried.end();
+                tried.push_back(position);
+            }
+            if (fits) {
+                pilots[g] = pilot;
+                for (size_t i = first; i < last; i++) {
+                    positionOfItem[i] = tried[i - first];
+                    taken[tried[i - first]] = 1;
+                }
+                break;
+            }
+        }
+    }
+
+    // Each used position past the end takes the next free slot
+    remap.assign(positionRange - slots, 0);
+    size_t freeSlot = 0;
+    for (size_t position = slots; position < positionRange; position++) {
+        if (!taken[position]) {
+            continue;
+        }
+        while (taken[freeSlot]) {
+            freeSlot++;
+        }
+        remap[position - slots] = freeSlot;
+        taken[freeSlot] = 1;
+    }
+
+    size_t keyBytes = 0;
+    for (const auto& item : placeable) {
+        keyBytes += item.second.first.size();
+    }
+    arena.reserve(keyBytes);
+    entries.resize(slots);
+    for (size_t i = 0; i < slots; i++) {
+        size_t position = positionOfItem[i];
+        size_t slot = position < slots ? position : remap[position - slots];
+        std::string_view key = placeable[i].second.first;
+        uint64_t keyRef = (static_cast<uint64_t>(arena.size()) << OFFSET_SHIFT) |
+                          fingerprintOf(placeable[i].first) | key.size();
+        entries[slot] = {placeable[i].second.second, keyRef};
+        arena.append(key);
+    }
+}
+
+//----------------------------------------------------------------
+// lookup: Finds the value for a key. Reads one pilot and one
+//             entry; the overflow list is checked only on a miss
+//             and is almost always empty.
+//    Returns:  value if found, std::nullopt if not found
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+std::optional<size_t> FrozenHashTable::lookup(std::string_view key) const {
+    if (!entries.empty()) {
+        uint64_t hash = hashMix64(key);
+        size_t slot = positionOf(hash, pilots[groupOf(hash)]);
+        if (slot >= entries.size()) {
+            slot = remap[slot - entries.size()];
+        }
+        const Entry& entry = entries[slot];
+        uint64_t expected = fingerprintOf(hash) | key.size();
+        if ((entry.keyRef & ((0xffULL << FINGERPRINT_SHIFT) | KEY_LENGTH_MASK)) == expected && keyOf(entry) == key) {
+            return entry.value;
+        }
+    }
+    for (const auto& [overflowKey, value] : overflow) {
+        if (overflowKey == key) {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+//----------------------------------------------------------------
+// contains: Checks for a key.
+//    Returns:  true if key in table, false otherwise (bool)
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+bool FrozenHashTable::contains(std::string_view key) const {
+    return lookup(key).has_value();
+}
+
+//----------------------------------------------------------------
+// get: Gets the value for a key.
+//    Returns:  value if found, std::nullopt if not found
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+std::optional<size_t> FrozenHashTable::get(std::string_view key) const {
+    return lookup(key);
+}
+
+//----------------------------------------------------------------
+// keys: Returns every key, in slot order.
+//    Returns:  vector of all keys (vector<string>)
+//---------------------------------------------------------------
+std::vector<std::string> FrozenHashTable::keys() const {
+    std::vector<std::string> result;
+    result.reserve(size());
+    for (const auto& entry : entries) {
+        result.emplace_back(keyOf(entry));
+    }
+    for (const auto& [key, value] : overflow) {
+        result.push_back(key);
+    }
+    return result;
+}
+
+//----------------------------------------------------------------
+// size: Returns the number of key value pairs.
+//    Returns:  number of elements (size_t)
+//---------------------------------------------------------------
+size_t FrozenHashTable::size() const {
+    return entries.size() + overflow.size();
+}
+
+//----------------------------------------------------------------
+// memoryBytes: Bytes held by the table: entries, key arena,
+//             pilots, remap array and overflow list.
+//    Returns:  bytes (size_t)
+//---------------------------------------------------------------
+size_t FrozenHashTable::memoryBytes() const {
+    size_t bytes = entries.capacity() * sizeof(Entry) + arena.capacity() +
+                   pilots.capacity() * sizeof(uint32_t) + remap.capacity() * sizeof(uint64_t);
+    for (const auto& [key, value] : overflow) {
+        bytes += sizeof(overflow[0]) + key.capacity();
+    }
+    return bytes;
+}
@@ -0,0 +1,68 @@
+/**
+ * FrozenHashTable.h
+ *
+ * Read-only table built once from a HashTable. Keys are placed with
+ * a minimal perfect hash (PTHash style): keys are split into small
+ * groups, and each group stores a "pilot" chosen at build time so
+ * that every key in the table gets its own slot in [0, n). A lookup
+ * hashes the key, reads one pilot, and reads exactly one entry; the
+ * key is compared only to reject keys that were never in the table.
+ *
+ * Memory is one 16-byte entry per key plus the key bytes, about one
+ * byte per key of pilots, and a small remap array. There are no
+ * empty buckets and no tombstones.
+ */
+#ifndef FROZENHASHTABLE_H
+#define FROZENHASHTABLE_H
+
+#include "HashTable.h"
+
+class FrozenHashTable {
+private:
+    // Entry is one key value pair; the key lives in the arena. keyRef
+    // packs the arena offset (bits 24-63), an 8-bit hash fingerprint
+    // (bits 16-23) and the key length (bits 0-15), so most misses
+    // are rejected without reading the arena.
+    struct Entry {
+        uint64_t value;
+        uint64_t keyRef;
+    };
+
+    static constexpr int OFFSET_SHIFT = 24;
+    static constexpr int FINGERPRINT_SHIFT = 16;
+    static constexpr uint64_t KEY_LENGTH_MASK = 0xffff;
+    static constexpr double KEYS_PER_GROUP = 4.0;   // Average group size
+    static constexpr double SLOT_LOAD = 0.98;       // n / position range
+
+    std::vector<Entry> entries;       // n entries, indexed by slot
+    std::string arena;                // Key bytes
+    std::vector<uint32_t> pilots;     // One per group
+    std::vector<uint64_t> remap;      // Slot for positions n and up
+    size_t positionRange = 0;
+
+    // Keys whose full hash equals another key's can never be separated
+    // by a pilot, and keys over 64 KB do not fit an entry; they are
+    // kept here instead. This is almost always empty.
+    std::vector<std::pair<std::string, size_t>> overflow;
+
+    // Full MIX64 hash of a key, then the key and its value
+    using Item = std::pair<uint64_t, std::pair<std::string_view, size_t>>;
+
+    size_t groupOf(uint64_t hash) const;
+    size_t positionOf(uint64_t hash, uint32_t pilot) const;
+    static uint64_t fingerprintOf(uint64_t hash);
+    std::string_view keyOf(const Entry& entry) const;
+    std::optional<size_t> lookup(std::string_view key) const;
+    void build(std::vector<Item>& items);
+
+public:
+    explicit FrozenHashTable(const HashTable& table);
+
+    bool contains(std::string_view key) const;
+    std::optional<size_t> get(std::string_view key) const;
+    std::vector<std::string> keys() const;
+    size_t size() const;
+    size_t memoryBytes() const;
+};
+
+#endif
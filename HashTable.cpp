@@ -6,365 +6,2245 @@
  */
 #include "HashTable.h"
 #include <algorithm>
-#include <random>
+#include <numeric>
+#include <cstring>
+#include <bit>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <utility>
+#include <exception>
+#include <stdexcept>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
+// HT_STAT(statement) runs statement only in HASHTABLE_STATS builds
+#ifdef HASHTABLE_STATS
+#define HT_STAT(statement) statement
+#else
+#define HT_STAT(statement)
+#endif
+
+namespace {
+
+// Mixing constants for the MIX64 hash (same family as wyhash)
+constexpr uint64_t MIX_P0 = 0xa0761d6478bd642fULL;
+constexpr uint64_t MIX_P1 = 0xe7037ed1a0b428dbULL;
+constexpr uint64_t MIX_P2 = 0x8ebc6af09c88c6e3ULL;
+
+//----------------------------------------------------------------
+// mum: Multiplies two 64-bit values into 128 bits and folds the
+//             high half into the low half.
+//    Returns:  folded product (uint64_t)
+//---------------------------------------------------------------
+uint64_t mum(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+    uint64_t aLo = a & 0xffffffffULL, aHi = a >> 32;
+    uint64_t bLo = b & 0xffffffffULL, bHi = b >> 32;
+    uint64_t lo = aLo * bLo, mid1 = aHi * bLo, mid2 = aLo * bHi, hi = aHi * bHi;
+    uint64_t cross = (lo >> 32) + (mid1 & 0xffffffffULL) + mid2;
+    hi += (mid1 >> 32) + (cross >> 32);
+    lo = (cross << 32) | (lo & 0xffffffffULL);
+    return lo ^ hi;
+#endif
+}
+
+uint64_t read64(const char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t read32(const char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+//----------------------------------------------------------------
+// mix64Hash: Hashes a byte string 16 bytes at a time with a
+//             multiply-fold round, then mixes in the tail.
+//    Returns:  64-bit hash (uint64_t)
+//    Parameters:
+//       data (const char*) - bytes to hash
+//       len (size_t) - number of bytes
+//---------------------------------------------------------------
+uint64_t mix64Hash(const char* data, size_t len) {
+    uint64_t seed = MIX_P0 ^ mum(len ^ MIX_P1, MIX_P2);
+    size_t rem = len;
+
+    while (rem > 16) {
+        seed = mum(read64(data) ^ MIX_P1, read64(data + 8) ^ seed);
+        data += 16;
+        rem -= 16;
+    }
+
+    uint64_t a = 0;
+    uint64_t b = 0;
+    if (rem >= 8) {
+        a = read64(data);
+        b = read64(data + rem - 8);
+    } else if (rem >= 4) {
+        a = read32(data);
+        b = read32(data + rem - 4);
+    } else if (rem > 0) {
+        a = (static_cast<uint64_t>(static_cast<unsigned char>(data[0])) << 16) |
+            (static_cast<uint64_t>(static_cast<unsigned char>(data[rem >> 1])) << 8) |
+            static_cast<uint64_t>(static_cast<unsigned char>(data[rem - 1]));
+    }
+
+    return mum(MIX_P1 ^ len, mum(a ^ MIX_P1, b ^ seed));
+}
+
+//----------------------------------------------------------------
+// prefetchRead: Asks the CPU to start loading the cache line at
+//             addr. Only a hint; it never faults.
+//    Returns:  void
+//    Parameters:
+//       addr (const void*) - address about to be read
+//---------------------------------------------------------------
+inline void prefetchRead(const void* addr) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(addr, 0, 3);
+#elif defined(__SSE2__) || defined(_M_X64)
+    _mm_prefetch(static_cast<const char*>(addr), _MM_HINT_T0);
+#else
+    (void)addr;
+#endif
+}
+
+//----------------------------------------------------------------
+// emptyMask: Scans a group of control bytes and sets one bit for
+//             every slot that is not holding data (ESS or EAR).
+//             Uses AVX2 (32 slots) or SSE2 (16 slots) when
+//             available, otherwise a byte loop over 16 slots.
+//    Returns:  bitmask, bit i set if ctrl[i] is empty (uint32_t)
+//    Parameters:
+//       ctrl (const uint8_t*) - first control byte of the group
+//---------------------------------------------------------------
+#if defined(__AVX2__)
+constexpr size_t CTRL_GROUP = 32;
+constexpr uint32_t CTRL_GROUP_MASK = 0xffffffffu;
+uint32_t emptyMask(const uint8_t* ctrl) {
+    __m256i group = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ctrl));
+    return static_cast<uint32_t>(_mm256_movemask_epi8(group));
+}
+#elif defined(__SSE2__)
+constexpr size_t CTRL_GROUP = 16;
+constexpr uint32_t CTRL_GROUP_MASK = 0xffffu;
+uint32_t emptyMask(const uint8_t* ctrl) {
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return static_cast<uint32_t>(_mm_movemask_epi8(group));
+}
+#else
+constexpr size_t CTRL_GROUP = 16;
+constexpr uint32_t CTRL_GROUP_MASK = 0xffffu;
+uint32_t emptyMask(const uint8_t* ctrl) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < CTRL_GROUP; i++) {
+        mask |= static_cast<uint32_t>(ctrl[i] >> 7) << i;
+    }
+    return mask;
+}
+#endif
+
+//----------------------------------------------------------------
+// nextPrime: Finds the smallest prime at least n, by trial
+//             division. Only called when the table grows, so the
+//             O(sqrt(n)) cost is small next to the rehash.
+//    Returns:  prime (size_t)
+//    Parameters:
+//       n (size_t) - lower bound
+//---------------------------------------------------------------
+size_t nextPrime(size_t n) {
+    if (n <= 2) {
+        return 2;
+    }
+    for (size_t candidate = n | 1; ; candidate += 2) {
+        bool isPrime = true;
+        for (size_t d = 3; d * d <= candidate; d += 2) {
+            if (candidate % d == 0) {
+                isPrime = false;
+                break;
+            }
+        }
+        if (isPrime) {
+            return candidate;
+        }
+    }
+}
+
+}
+
+//----------------------------------------------------------------
+// hashMix64: The MIX64 hash policy as a free function, for tables
+//             that hash keys without wrapping a HashTable.
+//    Returns:  64-bit hash (uint64_t)
+//    Parameters:
+//       key (string_view) - the key to hash
+//---------------------------------------------------------------
+uint64_t hashMix64(std::string_view key) {
+    return mix64Hash(key.data(), key.size());
+}
+
+//----------------------------------------------------------------
+// HashTable (constructor): Initializes the hash table with a
+//             given capacity. Creates a vector of empty buckets.
+//    Parameters:
+//       initCapacity (size_t) - initial number of buckets
+//       policy (HashPolicy) - hash used to place keys
+//       resizeMode (ResizeMode) - how the table grows
+//       probeSeed (uint64_t) - seed for the probe sequence
+//       memory (memory_resource*) - source of every array and of
+//             the key arena
+//---------------------------------------------------------------
+HashTable::HashTable(size_t initCapacity, HashPolicy policy, ResizeMode resizeMode, uint64_t probeSeed,
+                     std::pmr::memory_resource* memory)
+    : tableData(memory), valueData(memory), control(memory), keyArena(memory),
+      oldData(memory), oldValues(memory), oldControl(memory) {
+    tableData.resize(initCapacity);
+    valueData.resize(initCapacity);
+    control.assign(initCapacity, CTRL_EMPTY);
+    deadKeyBytes = 0;
+    numElements = 0;
+    numRemoved = 0;
+    maxTombstoneRatio = 0.25;
+    loadLimit = 0.5;
+    growth = GrowthPolicy::DOUBLE;
+    probing = ProbePolicy::DOUBLE_HASH;
+    this->policy = policy;
+    this->resizeMode = resizeMode;
+    this->probeSeed = probeSeed;
+    migrateIndex = 0;
+}
+
+//----------------------------------------------------------------
+// setInlineKey: Stores a key of at most INLINE_KEY_BYTES in the
+//             bucket, with its length in the last byte.
+//    Returns:  void
+//    Parameters:
+//       key (string_view) - the key to store
+//---------------------------------------------------------------
+void HashTableBucket::setInlineKey(std::string_view key) {
+    std::memcpy(keyData, key.data(), key.size());
+    keyData[7] = static_cast<char>(INLINE_FLAG | key.size());
+}
+
+//----------------------------------------------------------------
+// setArenaKey: Points the bucket at a key in the key arena. The
+//             length is written little-endian whatever the host
+//             byte order, so its top byte is the bucket's last.
+//    Returns:  void
+//    Parameters:
+//       offset (uint32_t) - where the key starts in the arena
+//       length (uint32_t) - key length, under 2 GiB
+//---------------------------------------------------------------
+void HashTableBucket::setArenaKey(uint32_t offset, uint32_t length) {
+    std::memcpy(keyData, &offset, sizeof(offset));
+    for (size_t i = 0; i < 4; i++) {
+        keyData[4 + i] = static_cast<char>(length >> (8 * i));
+    }
+}
+
+//----------------------------------------------------------------
+// KeyArena (constructor): Creates an empty arena. No memory is
+//             allocated until the first key.
+//    Parameters:
+//       memory (memory_resource*) - source of chunks and the index
+//---------------------------------------------------------------
+HashTable::KeyArena::KeyArena(std::pmr::memory_resource* memory)
+    : blocks(memory), chunks(memory) {
+}
+
+//----------------------------------------------------------------
+// KeyArena (copy): Copies every block into the default resource,
+//             so keys keep their offsets.
+//    Parameters:
+//       other (const KeyArena&) - arena to copy
+//---------------------------------------------------------------
+HashTable::KeyArena::KeyArena(const KeyArena& other) {
+    copyFrom(other);
+    used = other.used;
+    limit = other.limit;
+}
+
+//----------------------------------------------------------------
+// KeyArena (move): Takes other's chunks and its resource.
+//    Parameters:
+//       other (KeyArena&&) - arena to take over, left empty
+//---------------------------------------------------------------
+HashTable::KeyArena::KeyArena(KeyArena&& other) noexcept
+    : blocks(std::move(other.blocks)), chunks(std::move(other.chunks)),
+      used(std::exchange(other.used, 0)), limit(std::exchange(other.limit, 0)),
+      allocated(std::exchange(other.allocated, 0)) {
+    other.blocks.clear();
+    other.chunks.clear();
+}
+
+//----------------------------------------------------------------
+// operator= (KeyArena): Replaces this arena with a copy of other,
+//             allocated from this arena's resource.
+//    Returns:  this arena (KeyArena&)
+//    Parameters:
+//       other (const KeyArena&) - arena to copy
+//---------------------------------------------------------------
+HashTable::KeyArena& HashTable::KeyArena::operator=(const KeyArena& other) {
+    if (this != &other) {
+        clear();
+        copyFrom(other);
+        used = other.used;
+        limit = other.limit;
+    }
+    return *this;
+}
+
+//----------------------------------------------------------------
+// operator= (KeyArena, move): Takes other's chunks if both arenas
+//             share a resource, otherwise copies them into this
+//             arena's resource. Either way other is left empty.
+//    Returns:  this arena (KeyArena&)
+//    Parameters:
+//       other (KeyArena&&) - arena to take over
+//---------------------------------------------------------------
+HashTable::KeyArena& HashTable::KeyArena::operator=(KeyArena&& other) {
+    if (this == &other) {
+        return *this;
+    }
+    clear();
+    if (*resource() == *other.resource()) {
+        blocks.swap(other.blocks);
+        chunks.swap(other.chunks);
+        allocated = std::exchange(other.allocated, 0);
+    } else {
+        copyFrom(other);
+    }
+    used = other.used;
+    limit = other.limit;
+    other.clear();
+    return *this;
+}
+
+//----------------------------------------------------------------
+// ~KeyArena: Returns every chunk to the resource.
+//---------------------------------------------------------------
+HashTable::KeyArena::~KeyArena() {
+    clear();
+}
+
+//----------------------------------------------------------------
+// copyFrom (KeyArena): Appends a copy of each of other's blocks,
+//             allocated from this arena's resource. Keys keep their
+//             offsets when this arena starts empty.
+//    Returns:  void
+//    Parameters:
+//       other (const KeyArena&) - arena to copy
+//---------------------------------------------------------------
+void HashTable::KeyArena::copyFrom(const KeyArena& other) {
+    blocks.reserve(blocks.size() + other.blocks.size());
+    chunks.reserve(chunks.size() + other.chunks.size());
+    for (const Block& block : other.blocks) {
+        char* data = static_cast<char*>(resource()->allocate(block.bytes));
+        std::memcpy(data, block.data, block.bytes);
+        blocks.push_back({data, block.bytes});
+        for (size_t part = 0; part < block.bytes; part += CHUNK_BYTES) {
+            chunks.push_back(data + part);
+        }
+        allocated += block.bytes;
+    }
+}
+
+//----------------------------------------------------------------
+// append (KeyArena): Copies a key to the end of the arena. A key
+//             that does not fit the current chunk starts a new one,
+//             except that the first chunk doubles (moving what it
+//             holds) until it reaches CHUNK_BYTES. The old copy of
+//             the first chunk is freed only after key is copied, in
+//             case key points into it.
+//    Returns:  offset of the stored key (uint32_t); throws
+//             length_error if the key would end past MAX_BYTES,
+//             leaving the arena unchanged
+//    Parameters:
+//       key (string_view) - bytes to store
+//---------------------------------------------------------------
+uint32_t HashTable::KeyArena::append(std::string_view key) {
+    size_t start = used + key.size() <= limit ? used : chunks.size() << CHUNK_SHIFT;
+    if (start + key.size() > MAX_BYTES) {
+        throw std::length_error("HashTable key arena is full (4 GiB of keys)");
+    }
+
+    Block retired = {nullptr, 0};
+    if (used + key.size() > limit) {
+        if (blocks.size() == 1 && limit < CHUNK_BYTES && used + key.size() <= CHUNK_BYTES) {
+            size_t bytes = std::max(limit * 2, std::bit_ceil(used + key.size()));
+            char* grown = static_cast<char*>(resource()->allocate(bytes));
+            std::memcpy(grown, blocks[0].data, used);
+            retired = std::exchange(blocks[0], Block{grown, bytes});
+            chunks[0] = grown;
+            allocated += bytes - limit;
+            limit = bytes;
+        } else {
+            startChunk(key.size());
+        }
+    }
+
+    size_t offset = used;
+    std::memcpy(chunks[offset >> CHUNK_SHIFT] + (offset & (CHUNK_BYTES - 1)), key.data(), key.size());
+    used += key.size();
+    if (retired.data != nullptr) {
+        resource()->deallocate(retired.data, retired.bytes);
+    }
+    return static_cast<uint32_t>(offset);
+}
+
+//----------------------------------------------------------------
+// startChunk (KeyArena): Allocates the chunk the next key goes in,
+//             at the next chunk boundary; the rest of the current
+//             chunk is left unused. The first chunk is small. A key
+//             over CHUNK_BYTES gets a block spanning several chunk
+//             offsets, so it is still contiguous.
+//    Returns:  void
+//    Parameters:
+//       bytes (size_t) - size of the key that did not fit
+//---------------------------------------------------------------
+void HashTable::KeyArena::startChunk(size_t bytes) {
+    size_t start = chunks.size() << CHUNK_SHIFT;
+    size_t size = chunks.empty() ? std::bit_ceil(std::max(FIRST_CHUNK_BYTES, bytes)) : CHUNK_BYTES;
+    if (bytes > CHUNK_BYTES) {
+        size = (bytes + CHUNK_BYTES - 1) & ~(CHUNK_BYTES - 1);
+    }
+
+    char* data = static_cast<char*>(resource()->allocate(size));
+    blocks.push_back({data, size});
+    for (size_t part = 0; part < size; part += CHUNK_BYTES) {
+        chunks.push_back(data + part);
+    }
+    used = start;
+    limit = start + size;
+    allocated += size;
+}
+
+//----------------------------------------------------------------
+// adopt (KeyArena): Moves another arena's chunks to the end of this
+//             one. Nothing is copied if both arenas share a
+//             resource. A key at offset x in other is then at
+//             base + x here.
+//    Returns:  base to add to other's offsets (uint32_t); throws
+//             length_error, changing neither arena, if other's keys
+//             would end past MAX_BYTES
+//    Parameters:
+//       other (KeyArena&&) - arena to take over, left empty
+//---------------------------------------------------------------
+uint32_t HashTable::KeyArena::adopt(KeyArena&& other) {
+    size_t base = chunks.size() << CHUNK_SHIFT;
+    if (other.chunks.empty()) {
+        return static_cast<uint32_t>(base);
+    }
+    if (base + other.used > MAX_BYTES) {
+        throw std::length_error("HashTable key arena is full (4 GiB of keys)");
+    }
+
+    if (*resource() == *other.resource()) {
+        blocks.insert(blocks.end(), other.blocks.begin(), other.blocks.end());
+        chunks.insert(chunks.end(), other.chunks.begin(), other.chunks.end());
+        allocated += other.allocated;
+        other.blocks.clear();
+        other.chunks.clear();
+    } else {
+        copyFrom(other);
+    }
+    used = base + other.used;
+    limit = base + other.limit;
+    other.clear();
+    return static_cast<uint32_t>(base);
+}
+
+//----------------------------------------------------------------
+// clear (KeyArena): Frees every chunk, one deallocate per chunk.
+//    Returns:  void
+//---------------------------------------------------------------
+void HashTable::KeyArena::clear() {
+    for (const Block& block : blocks) {
+        resource()->deallocate(block.data, block.bytes);
+    }
+    blocks.clear();
+    chunks.clear();
+    used = 0;
+    limit = 0;
+    allocated = 0;
+}
+
+//----------------------------------------------------------------
+// usedBytes (KeyArena): Returns the offset the next key would get,
+//             counting chunk tails left unused.
+//    Returns:  bytes (size_t)
+//---------------------------------------------------------------
+size_t HashTable::KeyArena::usedBytes() const {
+    return used;
+}
+
+//----------------------------------------------------------------
+// allocatedBytes (KeyArena): Returns the bytes of every chunk and
+//             of the chunk index.
+//    Returns:  bytes (size_t)
+//---------------------------------------------------------------
+size_t HashTable::KeyArena::allocatedBytes() const {
+    return allocated + chunks.capacity() * sizeof(char*) +
+           blocks.capacity() * sizeof(Block);
+}
+
+//----------------------------------------------------------------
+// holds (KeyArena): Checks if a pointer is inside one of the chunks.
+//             O(chunks).
+//    Returns:  true if p points into the arena (bool)
+//    Parameters:
+//       p (const char*) - pointer to check
+//---------------------------------------------------------------
+bool HashTable::KeyArena::holds(const char* p) const {
+    std::less<const char*> before;
+    for (const Block& block : blocks) {
+        if (!before(p, block.data) && before(p, block.data + block.bytes)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//----------------------------------------------------------------
+// resource (KeyArena): Returns the memory resource chunks come from.
+//    Returns:  the resource (memory_resource*)
+//---------------------------------------------------------------
+std::pmr::memory_resource* HashTable::KeyArena::resource() const {
+    return blocks.get_allocator().resource();
+}
+
+//----------------------------------------------------------------
+// hasKey: Checks if a NORMAL bucket holds key. Compares the cached
+//             hash first so most mismatches never touch the arena.
+//    Returns:  true if the keys match (bool)
+//    Parameters:
+//       bucket (const HashTableBucket&) - bucket to check
+//       key (string_view) - the key to compare against
+//       hash (uint64_t) - full hash of key
+//---------------------------------------------------------------
+bool HashTable::hasKey(const HashTableBucket& bucket, std::string_view key, uint64_t hash) const {
+    return bucket.hash == hash && keyOf(bucket) == key;
+}
+
+//----------------------------------------------------------------
+// storeKey: Makes the bucket record for a key: the key itself if it
+//             fits inline, else its place in arena after appending
+//             it. Offsets are 32-bit: a table holds at most 4 GiB of
+//             key bytes.
+//    Returns:  bucket record for the key (HashTableBucket)
+//    Parameters:
+//       arena (KeyArena&) - arena for a key too long to inline
+//       key (string_view) - the key to store
+//       hash (uint64_t) - hashKey(key)
+//---------------------------------------------------------------
+HashTableBucket HashTable::storeKey(KeyArena& arena, std::string_view key, uint64_t hash) {
+    HashTableBucket bucket;
+    bucket.hash = hash;
+    if (key.size() <= HashTableBucket::INLINE_KEY_BYTES) {
+        bucket.setInlineKey(key);
+    } else {
+        bucket.setArenaKey(arena.append(key), static_cast<uint32_t>(key.size()));
+    }
+    return bucket;
+}
+
+//----------------------------------------------------------------
+// releaseKey: Records that a removed bucket's key bytes are no
+//             longer used. Once they outweigh both the live keys
+//             and the bucket count, the arena is rewritten, so the
+//             copying is paid for by the removes that caused it.
+//             Inline keys free nothing.
+//    Returns:  void
+//    Parameters:
+//       bucket (const HashTableBucket&) - bucket being removed
+//---------------------------------------------------------------
+void HashTable::releaseKey(const HashTableBucket& bucket) {
+    if (bucket.isInline()) {
+        return;
+    }
+    deadKeyBytes += bucket.keyLength();
+    if (deadKeyBytes * 2 > keyArena.usedBytes() && deadKeyBytes > tableData.size()) {
+        reclaimKeys();
+    }
+}
+
+//----------------------------------------------------------------
+// reclaimKeys: Rewrites the key arena with only the keys of NORMAL
+//             buckets, in bucket order, and frees the old chunks.
+//    Returns:  void
+//---------------------------------------------------------------
+void HashTable::reclaimKeys() {
+    // Copy every key before pointing any bucket at the new arena, so
+    // a full arena throws with the table unchanged
+    KeyArena packed(keyArena.resource());
+    std::vector<uint32_t> newOffsets;
+    auto forEachArenaKey = [&](auto&& visit) {
+        for (size_t i = nextNormal(0); i < tableData.size(); i = nextNormal(i + 1)) {
+            if (!tableData[i].isInline()) {
+                visit(tableData[i]);
+            }
+        }
+        for (size_t i = nextNormal(migrateIndex, true); i < oldData.size(); i = nextNormal(i + 1, true)) {
+            if (!oldData[i].isInline()) {
+                visit(oldData[i]);
+            }
+        }
+    };
+
+    forEachArenaKey([&](const HashTableBucket& bucket) {
+        newOffsets.push_back(packed.append(keyOf(bucket)));
+    });
+    size_t next = 0;
+    forEachArenaKey([&](HashTableBucket& bucket) {
+        bucket.setArenaKey(newOffsets[next++], bucket.keyLength());
+    });
+    keyArena = std::move(packed);
+    deadKeyBytes = 0;
+}
+
+//----------------------------------------------------------------
+// moveBucket: Moves a bucket's record, value and control byte to
+//             another index of tableData. The key stays where it
+//             is in the arena.
+//    Returns:  void
+//    Parameters:
+//       to (size_t) - destination bucket
+//       from (size_t) - source bucket
+//---------------------------------------------------------------
+void HashTable::moveBucket(size_t to, size_t from) {
+    tableData[to] = tableData[from];
+    valueData[to] = valueData[from];
+    control[to] = control[from];
+}
+
+//----------------------------------------------------------------
+// hashKey: Computes the full 64-bit hash of a key using the
+//             table's hash policy.
+//    Returns:  hash (uint64_t)
+//    Parameters:
+//       key (string_view) - the key to hash
+//---------------------------------------------------------------
+uint64_t HashTable::hashKey(std::string_view key) const {
+    return hashWith(key, policy);
+}
+
+//----------------------------------------------------------------
+// hashWith: Computes the full 64-bit hash of a key under a given
+//             hash policy.
+//    Returns:  hash (uint64_t)
+//    Parameters:
+//       key (string_view) - the key to hash
+//       policy (HashPolicy) - hash to use
+//---------------------------------------------------------------
+uint64_t HashTable::hashWith(std::string_view key, HashPolicy policy) {
+    if (policy == HashPolicy::LEGACY_SUM) {
+        uint64_t hash = 0;
+        for (char c : key) {
+            hash += static_cast<size_t>(c);
+        }
+        return hash;
+    }
+    return mix64Hash(key.data(), key.size());
+}
+
+//----------------------------------------------------------------
+// homeBucket: Computes home position for a hash as the hash
+//             mod table size.
+//    Returns:  bucket index (size_t)
+//    Parameters:
+//       hash (uint64_t) - full hash of the key
+//       cap (size_t) - number of buckets in the array probed
+//---------------------------------------------------------------
+size_t HashTable::homeBucket(uint64_t hash, size_t cap) const {
+    return hash % cap;
+}
+
+//----------------------------------------------------------------
+// controlTag: Computes the 7-bit fragment of a hash stored in
+//             the control byte of a NORMAL bucket. Uses the top
+//             bits so it is independent of the home bucket.
+//    Returns:  tag in [0, 127] (uint8_t)
+//    Parameters:
+//       hash (uint64_t) - full hash of the key
+//---------------------------------------------------------------
+uint8_t HashTable::controlTag(uint64_t hash) {
+    return static_cast<uint8_t>(hash >> 57);
+}
+
+//----------------------------------------------------------------
+// nextNormal: Finds the first NORMAL bucket at or after index by
+//             scanning control bytes a group at a time.
+//    Returns:  bucket index, or the array size if none (size_t)
+//    Parameters:
+//       index (size_t) - where to start scanning
+//       inOld (bool) - scan the old array of an incremental resize
+//---------------------------------------------------------------
+size_t HashTable::nextNormal(size_t index, bool inOld) const {
+    const std::pmr::vector<uint8_t>& ctrlBytes = inOld ? oldControl : control;
+    size_t cap = ctrlBytes.size();
+
+    while (index + CTRL_GROUP <= cap) {
+        uint32_t full = ~emptyMask(&ctrlBytes[index]) & CTRL_GROUP_MASK;
+        if (full != 0) {
+            return index + static_cast<size_t>(std::countr_zero(full));
+        }
+        index += CTRL_GROUP;
+    }
+
+    while (index < cap && ctrlBytes[index] >= CTRL_EMPTY) {
+        index++;
+    }
+    return index;
+}
+
+//----------------------------------------------------------------
+// advanceEntry: Moves an iterator position to the next NORMAL
+//             bucket, going from the end of tableData into the
+//             unmigrated part of the old array. The end position is
+//             (oldData.size(), true).
+//    Returns:  void
+//    Parameters:
+//       index (size_t&) - bucket index, updated
+//       inOld (bool&) - whether index is in the old array, updated
+//---------------------------------------------------------------
+void HashTable::advanceEntry(size_t& index, bool& inOld) const {
+    if (!inOld) {
+        index = nextNormal(index);
+        if (index < tableData.size()) {
+            return;
+        }
+        inOld = true;
+        index = migrateIndex;
+    }
+    index = nextNormal(index, true);
+}
+
+//----------------------------------------------------------------
+// probeStep: Picks the distance between probes for a hash. The
+//             step is pseudo-random in [1, cap - 1] and coprime
+//             with cap, so home, home + step, home + 2 * step, ...
+//             visits every bucket once. Keys with the same home
+//             usually get different steps, so they do not share a
+//             probe chain.
+//    Returns:  step (size_t)
+//    Parameters:
+//       hash (uint64_t) - full hash of the key
+//       cap (size_t) - number of buckets in the array probed
+//---------------------------------------------------------------
+size_t HashTable::probeStep(uint64_t hash, size_t cap) const {
+    return probeStepFor(hash, cap, probeSeed);
+}
+
+//----------------------------------------------------------------
+// probeStepFor: probeStep() for a given probe seed, for readers
+//             of a saved table layout.
+//    Returns:  step (size_t)
+//    Parameters:
+//       hash (uint64_t) - full hash of the key
+//       cap (size_t) - number of buckets in the array probed
+//       seed (uint64_t) - probe seed the layout was built with
+//---------------------------------------------------------------
+size_t HashTable::probeStepFor(uint64_t hash, size_t cap, uint64_t seed) {
+    if (cap <= 2) {
+        return 1;
+    }
+
+    uint64_t mixed = (hash ^ seed) * 0x9E3779B97F4A7C15ULL;
+    mixed ^= mixed >> 29;
+    size_t step = 1 + static_cast<size_t>(mixed % (cap - 1));
+
+    if ((cap & (cap - 1)) == 0) {
+        return step | 1;
+    }
+    while (std::gcd(step, cap) != 1) {
+        step = (step + 1 == cap) ? 1 : step + 1;
+    }
+    return step;
+}
+
+//----------------------------------------------------------------
+// nextProbe: Advances along the probe sequence of a hash. The
+//             step is computed on the first call only, so lookups
+//             that hit their home bucket never pay for it. Robin
+//             Hood tables always step by 1.
+//    Returns:  next bucket index (size_t)
+//    Parameters:
+//       probeIdx (size_t) - current bucket index
+//       hash (uint64_t) - full hash of the key
+//       cap (size_t) - number of buckets in the array probed
+//       step (size_t&) - 0 before the first call, then the step
+//---------------------------------------------------------------
+size_t HashTable::nextProbe(size_t probeIdx, uint64_t hash, size_t cap, size_t& step) const {
+    if (step == 0) {
+        step = probing == ProbePolicy::ROBIN_HOOD ? 1 : probeStep(hash, cap);
+    }
+    probeIdx += step;
+    if (probeIdx >= cap) {
+        probeIdx -= cap;
+    }
+    return probeIdx;
+}
+
+//----------------------------------------------------------------
+// findBucket: Finds the bucket containing a key using hash
+//             function and a per-hash probe step. Only the
+//             control byte is read per probe; the cached hash and
+//             key are compared only when the 7-bit tag matches.
+//             Robin Hood tables also stop at the first key that is
+//             closer to its home than key would be, since key would
+//             have taken that bucket. EAR buckets, which only occur
+//             in the old array there, are stepped over.
+//    Returns:  bucket index if found, SIZE_MAX if not found (size_t)
+//    Parameters:
+//       key (string_view) - the key to search for
+//       hash (uint64_t) - hashKey(key)
+//       probeCount (size_t*) - if not null, set to buckets examined
+//       inOld (bool) - search the old array of an incremental resize
+//---------------------------------------------------------------
+size_t HashTable::findBucket(std::string_view key, uint64_t hash, size_t* probeCount, bool inOld) const {
+    const std::pmr::vector<HashTableBucket>& data = inOld ? oldData : tableData;
+    const std::pmr::vector<uint8_t>& ctrlBytes = inOld ? oldControl : control;
+
+    size_t cap = data.size();
+    size_t probeIdx = homeBucket(hash, cap);
+    size_t step = 0;
+    uint8_t tag = controlTag(hash);
+    size_t probes = 0;
+    size_t result = SIZE_MAX;
+
+    for (size_t i = 0; i < cap; i++) {
+        uint8_t ctrl = ctrlBytes[probeIdx];
+        probes++;
+
+        if (ctrl == tag && hasKey(data[probeIdx], key, hash)) {
+            result = probeIdx;
+            break;
+        }
+
+        if (ctrl == CTRL_EMPTY) {
+            break;
+        }
+
+        if (probing == ProbePolicy::ROBIN_HOOD && ctrl != CTRL_DELETED &&
+            probeDistance(data[probeIdx].hash, probeIdx, cap) < i) {
+            break;
+        }
+
+        probeIdx = nextProbe(probeIdx, hash, cap, step);
+    }
+
+    HT_STAT(recordProbe(probes));
+    if (probeCount != nullptr) {
+        *probeCount = probes;
+    }
+    return result;
+}
+
+//----------------------------------------------------------------
+// findInsertBucket: Finds an empty bucket to insert a key using
+//             hash function and probing. Checks for duplicates
+//             all the way to the first ESS bucket, then reuses the
+//             first EAR bucket seen on the way if there was one.
+//    Returns:  bucket index if found, SIZE_MAX if duplicate or full (size_t)
+//    Parameters:
+//       key (string_view) - the key to insert
+//       hash (uint64_t) - hashKey(key)
+//       existing (size_t*) - if not null, set to the key's bucket
+//             when it is a duplicate
+//---------------------------------------------------------------
+size_t HashTable::findInsertBucket(std::string_view key, uint64_t hash, size_t* existing) {
+    if (probing == ProbePolicy::ROBIN_HOOD) {
+        return findRobinHoodBucket(key, hash, existing);
+    }
+
+    size_t cap = tableData.size();
+    size_t probeIdx = homeBucket(hash, cap);
+    size_t step = 0;
+    uint8_t tag = controlTag(hash);
+    size_t firstRemoved = SIZE_MAX;
+
+    for (size_t i = 0; i < cap; i++) {
+        uint8_t ctrl = control[probeIdx];
+
+        if (ctrl == tag && hasKey(tableData[probeIdx], key, hash)) {
+            HT_STAT(recordProbe(i + 1));
+            if (existing != nullptr) {
+                *existing = probeIdx;
+            }
+            return SIZE_MAX;
+        }
+
+        if (ctrl == CTRL_DELETED && firstRemoved == SIZE_MAX) {
+            firstRemoved = probeIdx;
+        }
+
+        if (ctrl == CTRL_EMPTY) {
+            HT_STAT(recordProbe(i + 1));
+            return firstRemoved != SIZE_MAX ? firstRemoved : probeIdx;
+        }
+
+        probeIdx = nextProbe(probeIdx, hash, cap, step);
+    }
+
+    HT_STAT(recordProbe(cap));
+    return firstRemoved;
+}
+
+//----------------------------------------------------------------
+// probeDistance: Computes how far a bucket is from the home bucket
+//             of the hash stored in it. Derived from the cached
+//             hash, so nothing extra is stored per bucket.
+//    Returns:  distance in buckets (size_t)
+//    Parameters:
+//       hash (uint64_t) - cached hash of the key in the bucket
+//       index (size_t) - bucket index
+//       cap (size_t) - number of buckets in the array
+//---------------------------------------------------------------
+size_t HashTable::probeDistance(uint64_t hash, size_t index, size_t cap) const {
+    size_t home = homeBucket(hash, cap);
+    return index >= home ? index - home : index + cap - home;
+}
+
+//----------------------------------------------------------------
+// findRobinHoodBucket: findInsertBucket() for Robin Hood tables.
+//             Walks from the home bucket until an empty bucket or a
+//             key closer to its home than key would be. Key belongs
+//             there: the "richer" key and everything after it up to
+//             the next empty bucket move forward one bucket, which
+//             is the same as swapping each one out in turn. A
+//             duplicate would have been met before that point.
+//    Returns:  empty bucket index, SIZE_MAX if duplicate or full (size_t)
+//    Parameters:
+//       key (string_view) - the key to insert
+//       hash (uint64_t) - hashKey(key)
+//       existing (size_t*) - if not null, set to the key's bucket
+//             when it is a duplicate
+//---------------------------------------------------------------
+size_t HashTable::findRobinHoodBucket(std::string_view key, uint64_t hash, size_t* existing) {
+    size_t cap = tableData.size();
+    size_t probeIdx = homeBucket(hash, cap);
+    uint8_t tag = controlTag(hash);
+
+    for (size_t i = 0; i < cap; i++) {
+        uint8_t ctrl = control[probeIdx];
+
+        if (ctrl == tag && hasKey(tableData[probeIdx], key, hash)) {
+            HT_STAT(recordProbe(i + 1));
+            if (existing != nullptr) {
+                *existing = probeIdx;
+            }
+            return SIZE_MAX;
+        }
+
+        if (ctrl == CTRL_EMPTY || probeDistance(tableData[probeIdx].hash, probeIdx, cap) < i) {
+            HT_STAT(recordProbe(i + 1));
+            shiftForward(probeIdx);
+            return probeIdx;
+        }
+
+        probeIdx = probeIdx + 1 == cap ? 0 : probeIdx + 1;
+    }
+
+    HT_STAT(recordProbe(cap));
+    return SIZE_MAX;
+}
+
+//----------------------------------------------------------------
+// shiftForward: Empties a bucket of a Robin Hood table by moving
+//             it and the NORMAL buckets after it forward one
+//             bucket, into the next empty bucket. Keys stay where
+//             they are in the arena. Does nothing if the bucket is
+//             empty.
+//    Returns:  void
+//    Parameters:
+//       index (size_t) - bucket to empty
+//---------------------------------------------------------------
+void HashTable::shiftForward(size_t index) {
+    size_t cap = tableData.size();
+    size_t end = index;
+    while (control[end] < CTRL_EMPTY) {
+        end = end + 1 == cap ? 0 : end + 1;
+    }
+
+    while (end != index) {
+        size_t prev = end == 0 ? cap - 1 : end - 1;
+        moveBucket(end, prev);
+        end = prev;
+    }
+    control[index] = CTRL_EMPTY;
+}
+
+//----------------------------------------------------------------
+// shiftBackward: Removes the key in a bucket of a Robin Hood table
+//             by backward-shift deletion. Each following key that
+//             is not in its home bucket moves back one bucket,
+//             stopping at an empty bucket or a key at home, and the
+//             last bucket moved from becomes ESS. No tombstone is
+//             left, so later misses still stop early.
+//    Returns:  void
+//    Parameters:
+//       index (size_t) - NORMAL bucket to clear
+//---------------------------------------------------------------
+void HashTable::shiftBackward(size_t index) {
+    size_t cap = tableData.size();
+    size_t next = index + 1 == cap ? 0 : index + 1;
+
+    HashTableBucket removed = tableData[index];
+    while (control[next] < CTRL_EMPTY && homeBucket(tableData[next].hash, cap) != next) {
+        moveBucket(index, next);
+        index = next;
+        next = next + 1 == cap ? 0 : next + 1;
+    }
+    control[index] = CTRL_EMPTY;
+    releaseKey(removed);
+}
+
+//----------------------------------------------------------------
+// lookup: Finds the value of key, checking the old array too
+//             while an incremental resize is in progress.
+//    Returns:  pointer to the value, nullptr if not found
+//    Parameters:
+//       key (string_view) - the key to search for
+//       hash (uint64_t) - hashKey(key)
+//---------------------------------------------------------------
+const size_t* HashTable::lookup(std::string_view key, uint64_t hash) const {
+    size_t bucketIdx = findBucket(key, hash);
+    if (bucketIdx != SIZE_MAX) {
+        HT_STAT(counters.hits++);
+        return &valueData[bucketIdx];
+    }
+
+    if (isMigrating()) {
+        bucketIdx = findBucket(key, hash, nullptr, true);
+        if (bucketIdx != SIZE_MAX) {
+            HT_STAT(counters.hits++);
+            return &oldValues[bucketIdx];
+        }
+    }
+    HT_STAT(counters.misses++);
+    return nullptr;
+}
+
+//----------------------------------------------------------------
+// findEmptyBucket: Finds the first bucket on the probe sequence
+//             of hash that holds no data. Does not check for
+//             duplicates, so it is only used to place keys that
+//             are already known to be unique.
+//    Returns:  bucket index, SIZE_MAX if the table is full (size_t)
+//    Parameters:
+//       hash (uint64_t) - full hash of the key to place
+//---------------------------------------------------------------
+size_t HashTable::findEmptyBucket(uint64_t hash) const {
+    size_t cap = tableData.size();
+    size_t probeIdx = homeBucket(hash, cap);
+    size_t step = 0;
+
+    for (size_t i = 0; i < cap; i++) {
+        if (control[probeIdx] >= CTRL_EMPTY) {
+            return probeIdx;
+        }
+        probeIdx = nextProbe(probeIdx, hash, cap, step);
+    }
+
+    return SIZE_MAX;
+}
+
+//----------------------------------------------------------------
+// rehashInto: Places a NORMAL bucket from another array into the
+//             first empty slot of its probe sequence in tableData.
+//             Its key stays in the arena and its cached hash is
+//             reused, so only the 16-byte record and the value are
+//             copied. Robin Hood tables place it in distance order
+//             instead.
+//    Returns:  void
+//    Parameters:
+//       bucket (const HashTableBucket&) - bucket to place
+//       value (size_t) - the bucket's value
+//---------------------------------------------------------------
+void HashTable::rehashInto(const HashTableBucket& bucket, size_t value) {
+    size_t bucketIdx = probing == ProbePolicy::ROBIN_HOOD
+                           ? findRobinHoodBucket(keyOf(bucket), bucket.hash)
+                           : findEmptyBucket(bucket.hash);
+    if (control[bucketIdx] == CTRL_DELETED) {
+        numRemoved--;
+    }
+    control[bucketIdx] = controlTag(bucket.hash);
+    tableData[bucketIdx] = bucket;
+    valueData[bucketIdx] = value;
+}
+
+//----------------------------------------------------------------
+// nextCapacity: Computes the capacity to grow to under the
+//             table's growth policy.
+//    Returns:  new capacity, always larger than cap (size_t)
+//    Parameters:
+//       cap (size_t) - current capacity
+//---------------------------------------------------------------
+size_t HashTable::nextCapacity(size_t cap) const {
+    switch (growth) {
+    case GrowthPolicy::ONE_AND_HALF:
+        return cap + std::max<size_t>(cap / 2, 1);
+    case GrowthPolicy::PRIME:
+        return nextPrime(cap * 2);
+    default:
+        return std::max<size_t>(cap * 2, 1);
+    }
+}
+
+//----------------------------------------------------------------
+// minCapacityFor: Computes the fewest buckets that hold count
+//             elements below the max load factor.
+//    Returns:  capacity (size_t)
+//    Parameters:
+//       count (size_t) - number of elements
+//---------------------------------------------------------------
+size_t HashTable::minCapacityFor(size_t count) const {
+    return static_cast<size_t>(static_cast<double>(count) / loadLimit) + 1;
+}
+
+//----------------------------------------------------------------
+// resize: Rehashes every element into a new array of the given
+//             size. Buckets are placed with rehashInto(), so no
+//             key is hashed again or checked for duplicates. Keys
+//             are not copied either, unless removed keys take up
+//             over 1/8 of the key arena: then the arena is
+//             compacted as part of the rehash.
+//    Returns:  void
+//    Parameters:
+//       newCapacity (size_t) - buckets in the new array
+//---------------------------------------------------------------
+void HashTable::resize(size_t newCapacity) {
+#ifdef HASHTABLE_STATS
+    auto start = std::chrono::steady_clock::now();
+#endif
+    std::pmr::vector<HashTableBucket> oldBuckets = std::move(tableData);
+    std::pmr::vector<size_t> oldVals = std::move(valueData);
+    std::pmr::vector<uint8_t> oldCtrl = std::move(control);
+
+    tableData.clear();
+    tableData.resize(newCapacity);
+    valueData.assign(newCapacity, 0);
+    control.assign(newCapacity, CTRL_EMPTY);
+    numRemoved = 0;
+
+    for (size_t i = 0; i < oldBuckets.size(); i++) {
+        if (oldCtrl[i] < CTRL_EMPTY) {
+            rehashInto(oldBuckets[i], oldVals[i]);
+        }
+    }
+    if (deadKeyBytes * 8 > keyArena.usedBytes()) {
+        reclaimKeys();
+    }
+    HT_STAT(recordResize(start));
+}
+
+//----------------------------------------------------------------
+// beginMigration: Starts an incremental resize. The current
+//             arrays become the old arrays and a new array of
+//             the given size is created. Elements are moved
+//             later by migrateStep().
+//    Returns:  void
+//    Parameters:
+//       newCapacity (size_t) - buckets in the new array
+//---------------------------------------------------------------
+void HashTable::beginMigration(size_t newCapacity) {
+#ifdef HASHTABLE_STATS
+    auto start = std::chrono::steady_clock::now();
+#endif
+    oldData = std::move(tableData);
+    oldValues = std::move(valueData);
+    oldControl = std::move(control);
+    migrateIndex = 0;
+
+    tableData.clear();
+    tableData.resize(newCapacity);
+    valueData.assign(newCapacity, 0);
+    control.assign(newCapacity, CTRL_EMPTY);
+    numRemoved = 0;
+    HT_STAT(recordResize(start));
+}
+
+//----------------------------------------------------------------
+// migrateStep: Moves the NORMAL buckets among the next budget
+//             old buckets into the new array. Moved buckets are
+//             marked EAR in the old array so they are not found
+//             twice. Frees the old arrays once all are moved.
+//    Returns:  void
+//    Parameters:
+//       budget (size_t) - number of old buckets to examine
+//---------------------------------------------------------------
+void HashTable::migrateStep(size_t budget) {
+    size_t end = std::min(migrateIndex + budget, oldData.size());
+
+    for (; migrateIndex < end; migrateIndex++) {
+        if (oldControl[migrateIndex] >= CTRL_EMPTY) {
+            continue;
+        }
+
+        rehashInto(oldData[migrateIndex], oldValues[migrateIndex]);
+        oldControl[migrateIndex] = CTRL_DELETED;
+    }
+
+    if (migrateIndex == oldData.size()) {
+        std::pmr::vector<HashTableBucket>(oldData.get_allocator()).swap(oldData);
+        std::pmr::vector<size_t>(oldValues.get_allocator()).swap(oldValues);
+        std::pmr::vector<uint8_t>(oldControl.get_allocator()).swap(oldControl);
+        migrateIndex = 0;
+    }
+}
+
+//----------------------------------------------------------------
+// grow: Grows the capacity under the growth policy, as many
+//             steps as it takes to get below the max load factor,
+//             using the table's resize mode.
+//    Returns:  void
+//---------------------------------------------------------------
+void HashTable::grow() {
+    size_t newCapacity = nextCapacity(tableData.size());
+    while (newCapacity < minCapacityFor(numElements + 1)) {
+        newCapacity = nextCapacity(newCapacity);
+    }
+
+    if (resizeMode == ResizeMode::INCREMENTAL) {
+        finishMigration();
+        beginMigration(newCapacity);
+    } else {
+        resize(newCapacity);
+    }
+}
+
+//----------------------------------------------------------------
+// compact: Clears every EAR bucket from tableData without
+//             changing capacity or allocating. NORMAL buckets are
+//             first marked as pending and EAR buckets as ESS. Each
+//             pending bucket then moves to the first non-NORMAL
+//             slot on its probe sequence: into it if that slot is
+//             ESS, or swapping with it if it is also pending.
+//             Every key ends up at or before the first ESS bucket
+//             on its sequence, so lookups still find it. Robin
+//             Hood tables have no EAR buckets, so there is nothing
+//             to do.
+//    Returns:  void
+//---------------------------------------------------------------
+void HashTable::compact() {
+    if (probing == ProbePolicy::ROBIN_HOOD) {
+        return;
+    }
+
+    // After this pass CTRL_DELETED means "pending", not EAR
+    for (size_t i = 0; i < control.size(); i++) {
+        if (control[i] == CTRL_DELETED) {
+            control[i] = CTRL_EMPTY;
+        } else if (control[i] < CTRL_EMPTY) {
+            control[i] = CTRL_DELETED;
+        }
+    }
+
+    for (size_t i = 0; i < control.size(); i++) {
+        while (control[i] == CTRL_DELETED) {
+            uint64_t hash = tableData[i].hash;
+            size_t target = findEmptyBucket(hash);
+
+            if (target == i) {
+                control[i] = controlTag(hash);
+            } else if (control[target] == CTRL_EMPTY) {
+                moveBucket(target, i);
+                control[target] = controlTag(hash);
+                control[i] = CTRL_EMPTY;
+            } else {
+                std::swap(tableData[i], tableData[target]);
+                std::swap(valueData[i], valueData[target]);
+                control[target] = controlTag(hash);
+            }
+        }
+    }
+
+    numRemoved = 0;
+    HT_STAT(counters.compactions++);
+}
+
+//----------------------------------------------------------------
+// clear: Removes every element but keeps the capacity. All key
+//             memory is freed at once, one chunk at a time, and the
+//             old array of an incremental resize is dropped.
+//    Returns:  void
+//---------------------------------------------------------------
+void HashTable::clear() {
+    std::pmr::vector<HashTableBucket>(oldData.get_allocator()).swap(oldData);
+    std::pmr::vector<size_t>(oldValues.get_allocator()).swap(oldValues);
+    std::pmr::vector<uint8_t>(oldControl.get_allocator()).swap(oldControl);
+    migrateIndex = 0;
+
+    control.assign(control.size(), CTRL_EMPTY);
+    keyArena.clear();
+    deadKeyBytes = 0;
+    numElements = 0;
+    numRemoved = 0;
+}
+
+//----------------------------------------------------------------
+// reserve: Makes room for count elements below the max load
+//             factor, so inserting up to count keys never resizes.
+//             Never shrinks the table.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of elements to make room for
+//---------------------------------------------------------------
+void HashTable::reserve(size_t count) {
+    size_t needed = minCapacityFor(count);
+    if (needed > tableData.size()) {
+        rehash(needed);
+    }
+}
+
+//----------------------------------------------------------------
+// rehash: Rebuilds the table with the given number of buckets,
+//             or the fewest that keep the current elements below
+//             the max load factor if that is more. Can shrink the
+//             table. Always stop-the-world, and clears tombstones.
+//    Returns:  void
+//    Parameters:
+//       buckets (size_t) - requested capacity
+//---------------------------------------------------------------
+void HashTable::rehash(size_t buckets) {
+    finishMigration();
+    resize(std::max({buckets, minCapacityFor(numElements), size_t{1}}));
+}
+
+//----------------------------------------------------------------
+// maxLoadFactor: Returns the load factor the table grows at.
+//    Returns:  max load factor (double)
+//---------------------------------------------------------------
+double HashTable::maxLoadFactor() const {
+    return loadLimit;
+}
+
+//----------------------------------------------------------------
+// setMaxLoadFactor: Sets the load factor the table grows at,
+//             clamped to [MIN_LOAD_FACTOR, MAX_LOAD_FACTOR]. Higher
+//             values use less memory per entry but make probe
+//             sequences longer. Takes effect on the next insert.
+//    Returns:  void
+//    Parameters:
+//       loadFactor (double) - new max load factor
+//---------------------------------------------------------------
+void HashTable::setMaxLoadFactor(double loadFactor) {
+    loadLimit = std::clamp(loadFactor, MIN_LOAD_FACTOR, MAX_LOAD_FACTOR);
+}
+
+//----------------------------------------------------------------
+// growthPolicy: Returns how the table picks its next capacity.
+//    Returns:  growth policy (GrowthPolicy)
+//---------------------------------------------------------------
+GrowthPolicy HashTable::growthPolicy() const {
+    return growth;
+}
+
+//----------------------------------------------------------------
+// setGrowthPolicy: Sets how the table picks its next capacity.
+//    Returns:  void
+//    Parameters:
+//       growthPolicy (GrowthPolicy) - new growth policy
+//---------------------------------------------------------------
+void HashTable::setGrowthPolicy(GrowthPolicy growthPolicy) {
+    growth = growthPolicy;
+}
+
+//----------------------------------------------------------------
+// probePolicy: Returns how the table places and removes keys.
+//    Returns:  probe policy (ProbePolicy)
+//---------------------------------------------------------------
+ProbePolicy HashTable::probePolicy() const {
+    return probing;
+}
+
+//----------------------------------------------------------------
+// setProbePolicy: Sets how the table places and removes keys.
+//             The layouts are not compatible, so a non-empty table
+//             is rebuilt at its current capacity.
+//    Returns:  void
+//    Parameters:
+//       probePolicy (ProbePolicy) - new probe policy
+//---------------------------------------------------------------
+void HashTable::setProbePolicy(ProbePolicy probePolicy) {
+    if (probePolicy == probing) {
+        return;
+    }
+    finishMigration();
+    probing = probePolicy;
+    if (numElements + numRemoved > 0) {
+        resize(tableData.size());
+    }
+}
+
+//----------------------------------------------------------------
+// finishMigration: Moves every remaining old bucket so that the
+//             incremental resize in progress, if any, completes.
+//    Returns:  void
+//---------------------------------------------------------------
+void HashTable::finishMigration() {
+    if (isMigrating()) {
+        migrateStep(oldData.size());
+    }
+}
+
 //----------------------------------------------------------------
-// HashTableBucket (default constructor): Creates an empty bucket
-//             in ESS (Empty Since Start) state.
+// ownsKeyBytes: Checks if key points into a bucket array, where
+//             inline keys live.
+//    Returns:  true if key's bytes belong to this table (bool)
+//    Parameters:
+//       key (string_view) - the key to check
 //---------------------------------------------------------------
-HashTableBucket::HashTableBucket() {
-    key = "";
-    value = 0;
-    type = BucketType::ESS;
+bool HashTable::ownsKeyBytes(std::string_view key) const {
+    auto inside = [&](const std::pmr::vector<HashTableBucket>& buckets) {
+        const char* begin = reinterpret_cast<const char*>(buckets.data());
+        const char* end = begin + buckets.size() * sizeof(HashTableBucket);
+        return !std::less<const char*>()(key.data(), begin) && std::less<const char*>()(key.data(), end);
+    };
+    return inside(tableData) || inside(oldData);
 }
 
 //----------------------------------------------------------------
-// HashTableBucket (parameterized constructor): Creates a bucket
-//             with data in NORMAL state.
+// prepareInsert: Does the work every insert shares before the key
+//             is stored. Grows the table if load factor reaches the
+//             max load factor (0.5 by default). If NORMAL plus EAR
+//             buckets reach the max load factor but fewer than 3/4
+//             of that are NORMAL, compacts in place instead of
+//             growing. Then finds a bucket for key.
+//             A key viewed from this table (an iterator's key) may
+//             move before fillBucket() copies it, so it is first
+//             copied to keyCopy and key is pointed there. Inline
+//             keys can move on any insert; arena keys only when
+//             growing or compacting, which is rare enough that
+//             searching the arena's chunks then costs nothing.
+//    Returns:  bucket index, SIZE_MAX if key is a duplicate (size_t)
 //    Parameters:
-//       key (string) - the key for this bucket
-//       value (size_t) - the value associated with the key
+//       key (string_view&) - the key to insert
+//       hash (uint64_t) - hashKey(key)
+//       keyCopy (string&) - storage for a copy of key
+//       existing (size_t**) - if not null, set to the value of
+//             key when it is a duplicate
 //---------------------------------------------------------------
-HashTableBucket::HashTableBucket(std::string key, size_t value) {
-    this->key = key;
-    this->value = value;
-    this->type = BucketType::NORMAL;
+size_t HashTable::prepareInsert(std::string_view& key, uint64_t hash, std::string& keyCopy, size_t** existing) {
+    double limit = static_cast<double>(tableData.size()) * loadLimit;
+    bool rebuilds = static_cast<double>(numElements + numRemoved) >= limit;
+    if (ownsKeyBytes(key) || (rebuilds && keyArena.holds(key.data()))) {
+        keyCopy.assign(key);
+        key = keyCopy;
+    }
+
+    if (isMigrating()) {
+        migrateStep(MIGRATE_STEP);
+    }
+
+    if (alpha() >= loadLimit) {
+        grow();
+    } else if (static_cast<double>(numElements + numRemoved) >= limit) {
+        if (static_cast<double>(numElements) < limit * 0.75) {
+            compact();
+        } else {
+            grow();
+        }
+    }
+
+    if (isMigrating()) {
+        size_t oldIdx = findBucket(key, hash, nullptr, true);
+        if (oldIdx != SIZE_MAX) {
+            if (existing != nullptr) {
+                *existing = &oldValues[oldIdx];
+            }
+            return SIZE_MAX;
+        }
+    }
+
+    size_t duplicateIdx = SIZE_MAX;
+    size_t bucketIdx = findInsertBucket(key, hash, &duplicateIdx);
+    if (existing != nullptr && duplicateIdx != SIZE_MAX) {
+        *existing = &valueData[duplicateIdx];
+    }
+    return bucketIdx;
 }
 
 //----------------------------------------------------------------
-// load: Load a key-value pair into the bucket and mark as NORMAL.
+// fillBucket: Stores a new key value pair in a bucket returned by
+//             prepareInsert().
 //    Returns:  void
 //    Parameters:
-//       key (string) - the key to load
-//       value (size_t) - the value to load
+//       bucketIdx (size_t) - bucket to fill
+//       key (string_view) - the key, copied into the key arena
+//       value (size_t) - the value to associate with the key
+//       hash (uint64_t) - hashKey(key)
+//---------------------------------------------------------------
+void HashTable::fillBucket(size_t bucketIdx, std::string_view key, size_t value, uint64_t hash) {
+    tableData[bucketIdx] = storeKey(keyArena, key, hash);
+    if (control[bucketIdx] == CTRL_DELETED) {
+        numRemoved--;
+    }
+    valueData[bucketIdx] = value;
+    control[bucketIdx] = controlTag(hash);
+    numElements++;
+    HT_STAT(counters.inserts++);
+}
+
+//----------------------------------------------------------------
+// insert: Inserts a key value pair into the table. Rejects
+//             duplicates and the reserved value 9999. The key is
+//             copied into the key arena only if it is new.
+//    Returns:  true if successful, false if duplicate or value is 9999 (bool)
+//    Parameters:
+//       key (string_view) - the key to insert
+//       value (size_t) - the value to associate with the key
+//---------------------------------------------------------------
+bool HashTable::insert(std::string_view key, size_t value) {
+    if (value == 9999) {
+        return false;
+    }
+
+    uint64_t hash = hashKey(key);
+    std::string keyCopy;
+    size_t bucketIdx = prepareInsert(key, hash, keyCopy);
+
+    if (bucketIdx == SIZE_MAX) {
+        return false;
+    }
+
+    fillBucket(bucketIdx, key, value, hash);
+    return true;
+}
+
+//----------------------------------------------------------------
+// insert (rvalue): Forwards to insert(string_view). Keys are
+//             copied into the key arena either way, so there is no
+//             storage to take over; kept so callers that move keys
+//             in still compile.
+//    Returns:  true if successful, false if duplicate or value is 9999 (bool)
+//    Parameters:
+//       key (string&&) - the key to insert
+//       value (size_t) - the value to associate with the key
+//---------------------------------------------------------------
+bool HashTable::insert(std::string&& key, size_t value) {
+    return insert(std::string_view(key), value);
+}
+
+//----------------------------------------------------------------
+// insert (C string): Forwards to insert(string_view). Needed so
+//             string literals do not match both other overloads.
+//    Returns:  true if successful, false if duplicate or value is 9999 (bool)
+//    Parameters:
+//       key (const char*) - the key to insert
+//       value (size_t) - the value to associate with the key
+//---------------------------------------------------------------
+bool HashTable::insert(const char* key, size_t value) {
+    return insert(std::string_view(key), value);
+}
+
+//----------------------------------------------------------------
+// remove: Removes a key value pair from the table by marking
+//             the bucket as EAR. The key may still be in the old
+//             array during an incremental resize. Compacts the
+//             table if EAR buckets pass the max tombstone ratio.
+//             Robin Hood tables shift the following keys back
+//             instead, outside the old array.
+//    Returns:  true if removed, false if key not found (bool)
+//    Parameters:
+//       key (string_view) - the key to remove
 //---------------------------------------------------------------
-void HashTableBucket::load(std::string key, size_t value) {
-    this->key = key;
-    this->value = value;
-    this->type = BucketType::NORMAL;
+bool HashTable::remove(std::string_view key) {
+    return removeHashed(key, hashKey(key));
 }
 
-//----------------------------------------------------------------
-// getKey: Returns the key stored in this bucket.
-//    Returns:  key (string)
-//---------------------------------------------------------------
-string HashTableBucket::getKey() const {
-    return key;
+//----------------------------------------------------------------
+// removeHashed: remove() for a key whose hash is already known.
+//    Returns:  true if removed, false if key not found (bool)
+//    Parameters:
+//       key (string_view) - the key to remove
+//       hash (uint64_t) - hashKey(key)
+//---------------------------------------------------------------
+bool HashTable::removeHashed(std::string_view key, uint64_t hash) {
+    if (isMigrating()) {
+        migrateStep(MIGRATE_STEP);
+    }
+
+    size_t bucketIdx = findBucket(key, hash);
+
+    if (bucketIdx != SIZE_MAX && probing == ProbePolicy::ROBIN_HOOD) {
+        shiftBackward(bucketIdx);
+        numElements--;
+        HT_STAT(counters.removes++);
+        return true;
+    }
+
+    if (bucketIdx != SIZE_MAX) {
+        control[bucketIdx] = CTRL_DELETED;
+        numElements--;
+        numRemoved++;
+        HT_STAT(counters.removes++);
+        releaseKey(tableData[bucketIdx]);
+        if (tombstoneRatio() > maxTombstoneRatio) {
+            compact();
+        }
+        return true;
+    }
+
+    if (isMigrating()) {
+        bucketIdx = findBucket(key, hash, nullptr, true);
+        if (bucketIdx != SIZE_MAX) {
+            oldControl[bucketIdx] = CTRL_DELETED;
+            numElements--;
+            HT_STAT(counters.removes++);
+            releaseKey(oldData[bucketIdx]);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//----------------------------------------------------------------
+// contains: Checks if a key exists in the table.
+//    Returns:  true if key in table, false otherwise (bool)
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+bool HashTable::contains(std::string_view key) const {
+    return lookup(key, hashKey(key)) != nullptr;
+}
+
+//----------------------------------------------------------------
+// get: Gets the value associated with a key.
+//    Returns:  value if found, std::nullopt if not found
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+std::optional<size_t> HashTable::get(std::string_view key) const {
+    const size_t* value = lookup(key, hashKey(key));
+
+    if (value == nullptr) {
+        return std::nullopt;
+    }
+
+    return *value;
 }
 
 //----------------------------------------------------------------
-// getValue: Returns the value stored in this bucket.
-//    Returns:  value (size_t)
+// operator[]: Bracket operator. Returns reference for reading
+//   Undefined behavior if key not in table.
+//    Returns:  reference to value (size_t&)
+//    Parameters:
+//       key (string_view) - the key to access
 //---------------------------------------------------------------
-size_t HashTableBucket::getValue() const {
-    return value;
+size_t& HashTable::operator[](std::string_view key) {
+    if (isMigrating()) {
+        migrateStep(MIGRATE_STEP);
+    }
+
+    uint64_t hash = hashKey(key);
+    size_t bucketIdx = findBucket(key, hash);
+
+    HT_STAT(counters.hits++);
+    if (bucketIdx == SIZE_MAX && isMigrating()) {
+        return oldValues[findBucket(key, hash, nullptr, true)];
+    }
+    return valueData[bucketIdx];
 }
 
 //----------------------------------------------------------------
-// getValueRef: Returns a reference to the value in this bucket.
-//    Returns:  reference to value
+// findOrInsert: Finds key, or inserts it with value if it is
+//             missing, in one probe sequence: the walk that looks
+//             for the key also finds the bucket it would go in.
+//    Returns:  reference to the key's value (size_t&)
+//    Parameters:
+//       key (string_view) - the key to find or insert
+//       hash (uint64_t) - hashKey(key)
+//       value (size_t) - value for a new key
+//       inserted (bool&) - set to true if key was new
 //---------------------------------------------------------------
-size_t& HashTableBucket::getValueRef() {
-    return value;
+size_t& HashTable::findOrInsert(std::string_view key, uint64_t hash, size_t value, bool& inserted) {
+    size_t* existing = nullptr;
+    std::string keyCopy;
+    size_t bucketIdx = prepareInsert(key, hash, keyCopy, &existing);
+
+    inserted = existing == nullptr;
+    if (!inserted) {
+        HT_STAT(counters.hits++);
+        return *existing;
+    }
+    fillBucket(bucketIdx, key, value, hash);
+    return valueData[bucketIdx];
 }
 
 //----------------------------------------------------------------
-// isNormal: Checks if this bucket contains valid data.
-//    Returns:  true if bucket is NORMAL, false otherwise
+// insertOrAssign: Sets the value of key, inserting it if missing.
+//    Returns:  true if key was inserted, false if assigned (bool)
+//    Parameters:
+//       key (string_view) - the key to set
+//       value (size_t) - the new value
 //---------------------------------------------------------------
-bool HashTableBucket::isNormal() const {
-    return type == BucketType::NORMAL;
+bool HashTable::insertOrAssign(std::string_view key, size_t value) {
+    bool inserted = false;
+    findOrInsert(key, hashKey(key), value, inserted) = value;
+    return inserted;
 }
 
 //----------------------------------------------------------------
-// isEmpty: Checks if bucket is empty, ESS or EAR.
-//    Returns:  true if empty, false otherwise (bool)
+// tryEmplace: Inserts key with value if it is missing. An existing
+//             value is left alone.
+//    Returns:  reference to the key's value, and true if inserted
+//    Parameters:
+//       key (string_view) - the key to insert
+//       value (size_t) - value for a new key
 //---------------------------------------------------------------
-bool HashTableBucket::isEmpty() const {
-    return type == BucketType::ESS || type == BucketType::EAR;
+std::pair<size_t&, bool> HashTable::tryEmplace(std::string_view key, size_t value) {
+    bool inserted = false;
+    size_t& stored = findOrInsert(key, hashKey(key), value, inserted);
+    return {stored, inserted};
 }
 
 //----------------------------------------------------------------
-// isEmptySinceStart: Checks if bucket has never been used.
-//    Returns:  true if ESS, false otherwise (bool)
+// getOrInsert: Returns the value of key, inserting defaultValue
+//             first if key is missing. The safe counterpart to
+//             operator[] for keys that may not exist.
+//    Returns:  reference to the key's value (size_t&)
+//    Parameters:
+//       key (string_view) - the key to look up
+//       defaultValue (size_t) - value for a new key
 //---------------------------------------------------------------
-bool HashTableBucket::isEmptySinceStart() const {
-    return type == BucketType::ESS;
+size_t& HashTable::getOrInsert(std::string_view key, size_t defaultValue) {
+    bool inserted = false;
+    return findOrInsert(key, hashKey(key), defaultValue, inserted);
 }
 
 //----------------------------------------------------------------
-// isEmptyAfterRemove: Checks if bucket had data that was removed.
-//    Returns:  true if EAR, false otherwise (bool)
+// fetchAdd: Adds delta to the value of key, treating a missing key
+//             as 0. Made for counters: one call per event.
+//    Returns:  the value before the add, 0 if key was new (size_t)
+//    Parameters:
+//       key (string_view) - the counter to update
+//       delta (size_t) - amount to add
 //---------------------------------------------------------------
-bool HashTableBucket::isEmptyAfterRemove() const {
-    return type == BucketType::EAR;
+size_t HashTable::fetchAdd(std::string_view key, size_t delta) {
+    bool inserted = false;
+    size_t& stored = findOrInsert(key, hashKey(key), 0, inserted);
+    size_t previous = stored;
+    stored += delta;
+    return previous;
 }
 
 //----------------------------------------------------------------
-// makeNormal: Sets bucket state to NORMAL.
+// prefetchHome: Prefetches the control byte and bucket that a
+//             lookup of hash will read first.
 //    Returns:  void
+//    Parameters:
+//       hash (uint64_t) - full hash of the key
 //---------------------------------------------------------------
-void HashTableBucket::makeNormal() {
-    type = BucketType::NORMAL;
+void HashTable::prefetchHome(uint64_t hash) const {
+    size_t home = homeBucket(hash, tableData.size());
+    prefetchRead(&control[home]);
+    prefetchRead(&tableData[home]);
 }
 
 //----------------------------------------------------------------
-// makeESS: Sets bucket state to ESS
+// getBatchImpl: Looks up keys BATCH_CHUNK at a time. Each chunk
+//             is hashed and its home buckets prefetched before any
+//             probe runs, so the cache misses overlap instead of
+//             happening one after another.
 //    Returns:  void
+//    Parameters:
+//       keys (span<const KeyT>) - keys to look up
+//       out (span<optional<size_t>>) - value for each key, or nullopt
 //---------------------------------------------------------------
-void HashTableBucket::makeESS() {
-    type = BucketType::ESS;
+template <typename KeyT>
+void HashTable::getBatchImpl(std::span<const KeyT> keys, std::span<std::optional<size_t>> out) const {
+    std::array<uint64_t, BATCH_CHUNK> hashes;
+
+    for (size_t base = 0; base < keys.size(); base += BATCH_CHUNK) {
+        size_t count = std::min(BATCH_CHUNK, keys.size() - base);
+        for (size_t j = 0; j < count; j++) {
+            hashes[j] = hashKey(keys[base + j]);
+            prefetchHome(hashes[j]);
+        }
+        for (size_t j = 0; j < count; j++) {
+            const size_t* value = lookup(keys[base + j], hashes[j]);
+            out[base + j] = value ? std::optional<size_t>(*value) : std::nullopt;
+        }
+    }
 }
 
 //----------------------------------------------------------------
-// makeEAR: Sets bucket state to EAR
+// containsBatchImpl: Same as getBatchImpl but only reports if
+//             each key is present.
 //    Returns:  void
+//    Parameters:
+//       keys (span<const KeyT>) - keys to look up
+//       out (span<bool>) - true for each key in the table
 //---------------------------------------------------------------
-void HashTableBucket::makeEAR() {
-    type = BucketType::EAR;
+template <typename KeyT>
+void HashTable::containsBatchImpl(std::span<const KeyT> keys, std::span<bool> out) const {
+    std::array<uint64_t, BATCH_CHUNK> hashes;
+
+    for (size_t base = 0; base < keys.size(); base += BATCH_CHUNK) {
+        size_t count = std::min(BATCH_CHUNK, keys.size() - base);
+        for (size_t j = 0; j < count; j++) {
+            hashes[j] = hashKey(keys[base + j]);
+            prefetchHome(hashes[j]);
+        }
+        for (size_t j = 0; j < count; j++) {
+            out[base + j] = lookup(keys[base + j], hashes[j]) != nullptr;
+        }
+    }
 }
 
 //----------------------------------------------------------------
-// HashTable (constructor): Initializes the hash table with a
-//             given capacity. Creates a vector of empty buckets.
+// insertBatchImpl: Inserts keys[i] with values[i], hashing and
+//             prefetching a chunk at a time like getBatchImpl.
+//             A resize inside a chunk only makes the remaining
+//             prefetches useless; the hashes stay valid.
+//    Returns:  number of keys inserted (size_t)
 //    Parameters:
-//       initCapacity (size_t) - initial number of buckets
+//       keys (span<const KeyT>) - keys to insert
+//       values (span<const size_t>) - value for each key
+//       inserted (span<bool>) - if not empty, true for each new key
 //---------------------------------------------------------------
-HashTable::HashTable(size_t initCapacity) {
-    tableData.resize(initCapacity);
-    numElements = 0;
-    generateOffsets(initCapacity);
+template <typename KeyT>
+size_t HashTable::insertBatchImpl(std::span<const KeyT> keys, std::span<const size_t> values, std::span<bool> inserted) {
+    std::array<uint64_t, BATCH_CHUNK> hashes;
+    std::string keyCopy;
+    size_t added = 0;
+
+    for (size_t base = 0; base < keys.size(); base += BATCH_CHUNK) {
+        size_t count = std::min(BATCH_CHUNK, keys.size() - base);
+        for (size_t j = 0; j < count; j++) {
+            hashes[j] = hashKey(keys[base + j]);
+            prefetchHome(hashes[j]);
+        }
+        for (size_t j = 0; j < count; j++) {
+            size_t i = base + j;
+            std::string_view key(keys[i]);
+            size_t bucketIdx = SIZE_MAX;
+            if (values[i] != 9999) {
+                bucketIdx = prepareInsert(key, hashes[j], keyCopy);
+            }
+            if (bucketIdx != SIZE_MAX) {
+                fillBucket(bucketIdx, key, values[i], hashes[j]);
+                added++;
+            }
+            if (!inserted.empty()) {
+                inserted[i] = bucketIdx != SIZE_MAX;
+            }
+        }
+    }
+    return added;
 }
 
 //----------------------------------------------------------------
-// hashFunction: Computes home position for a key using sum of
-//             ASCII values mod table size.
-//    Returns:  bucket index (size_t)
+// getBatch: Looks up many keys at once with prefetching. Makes
+//             no allocations.
+//    Returns:  void
 //    Parameters:
-//       key (string) - the key to hash
+//       keys (span) - keys to look up
+//       out (span<optional<size_t>>) - value for each key, or nullopt
 //---------------------------------------------------------------
-size_t HashTable::hashFunction(const std::string& key) const {
-    size_t hash = 0;
-    for (char c : key) {
-        hash += static_cast<size_t>(c);
-    }
-    return hash % tableData.size();
+void HashTable::getBatch(std::span<const std::string_view> keys, std::span<std::optional<size_t>> out) const {
+    getBatchImpl(keys, out);
+}
+
+void HashTable::getBatch(std::span<const std::string> keys, std::span<std::optional<size_t>> out) const {
+    getBatchImpl(keys, out);
 }
 
 //----------------------------------------------------------------
-// generateOffsets: Generates pseudo-random probe offsets by
-//             creating array [1, 2, ..., capacity-1] then
-//             shuffling it using std::shuffle.
+// containsBatch: Checks many keys at once with prefetching.
+//             Makes no allocations.
 //    Returns:  void
 //    Parameters:
-//       capacity (size_t) - the table capacity
-//https://en.cppreference.com/w/cpp/numeric/random.html
+//       keys (span) - keys to look up
+//       out (span<bool>) - true for each key in the table
 //---------------------------------------------------------------
-void HashTable::generateOffsets(size_t capacity) {
-    offsets.clear();
-    offsets.resize(capacity - 1);
-
-    for (size_t i = 0; i < capacity - 1; i++) {
-        offsets[i] = i + 1;
-    }
+void HashTable::containsBatch(std::span<const std::string_view> keys, std::span<bool> out) const {
+    containsBatchImpl(keys, out);
+}
 
-    std::random_device rd;
-    std::mt19937 g(rd()); // https://en.cppreference.com/w/cpp/numeric/random.html
-    std::shuffle(offsets.begin(), offsets.end(), g);
+void HashTable::containsBatch(std::span<const std::string> keys, std::span<bool> out) const {
+    containsBatchImpl(keys, out);
 }
 
 //----------------------------------------------------------------
-// findBucket: Finds the bucket containing a key using hash
-//             function and pseudo-random probing.
-//    Returns:  bucket index if found, SIZE_MAX if not found (size_t)
+// insertBatch: Inserts many key value pairs at once with
+//             prefetching. Same rules as insert(): duplicates and
+//             the value 9999 are rejected.
+//    Returns:  number of keys inserted (size_t)
 //    Parameters:
-//       key (string) - the key to search for
+//       keys (span) - keys to insert
+//       values (span<const size_t>) - value for each key
+//       inserted (span<bool>) - if not empty, true for each new key
 //---------------------------------------------------------------
-size_t HashTable::findBucket(const std::string& key) const {
-    size_t home = hashFunction(key);
-    size_t cap = tableData.size();
+size_t HashTable::insertBatch(std::span<const std::string_view> keys, std::span<const size_t> values, std::span<bool> inserted) {
+    return insertBatchImpl(keys, values, inserted);
+}
 
-    if (tableData[home].isNormal() && tableData[home].getKey() == key) {
-        return home;
-    }
+size_t HashTable::insertBatch(std::span<const std::string> keys, std::span<const size_t> values, std::span<bool> inserted) {
+    return insertBatchImpl(keys, values, inserted);
+}
 
-    if (tableData[home].isEmptySinceStart()) {
-        return SIZE_MAX;
+//----------------------------------------------------------------
+// buildFromImpl: Builds a table from parallel key and value spans.
+//             The table is sized once for every pair. The bucket
+//             array is split into one range per thread and each
+//             pair goes to the thread owning its home bucket, so all
+//             copies of a key go to the same thread, in input order.
+//             Each thread copies its input chunk's keys into its own
+//             arena while hashing. The arenas are then joined
+//             without copying, so the table's arena is only read
+//             while threads probe. Bytes of dropped duplicates are
+//             reclaimed afterwards if they are over half the arena.
+//             A thread claims a bucket by swapping its control byte
+//             from CTRL_EMPTY to a busy marker, fills it, then
+//             publishes the tag. Tags seen while probing are
+//             therefore either finished buckets, safe to compare,
+//             or another thread's key in progress, never a copy.
+//    Returns:  the filled table (HashTable)
+//    Parameters:
+//       keys (span<const KeyT>) - keys to insert
+//       values (span<const size_t>) - value for each key
+//       threadCount (size_t) - worker threads, 0 for one per core
+//       duplicates (vector<size_t>*) - if not null, receives the
+//             sorted indexes of pairs dropped as duplicates
+//---------------------------------------------------------------
+template <typename KeyT>
+HashTable HashTable::buildFromImpl(std::span<const KeyT> keys, std::span<const size_t> values,
+                                   size_t threadCount, std::vector<size_t>* duplicates) {
+    size_t n = keys.size();
+    if (threadCount == 0) {
+        threadCount = std::max<size_t>(1, std::thread::hardware_concurrency());
     }
+    threadCount = std::clamp<size_t>(n / BUILD_MIN_PER_THREAD, 1, threadCount);
 
-    for (size_t i = 0; i < offsets.size(); i++) {
-        size_t probeIdx = (home + offsets[i]) % cap;
+    // Below the default max load factor, so the next insert() does not grow
+    HashTable table(std::max(DEFAULT_INITIAL_CAPACITY, n * 2 + 1));
+    size_t cap = table.tableData.size();
+    size_t rangeSize = (cap + threadCount - 1) / threadCount;
 
-        if (tableData[probeIdx].isNormal() && tableData[probeIdx].getKey() == key) {
-            return probeIdx;
+    // A worker that throws (a full key arena) hands the exception back
+    // to be rethrown once every thread has joined
+    auto runParallel = [threadCount](auto&& work) {
+        std::vector<std::exception_ptr> errors(threadCount);
+        auto guarded = [&](size_t t) {
+            try {
+                work(t);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < threadCount; t++) {
+            workers.emplace_back(guarded, t);
         }
-
-        if (tableData[probeIdx].isEmptySinceStart()) {
-            return SIZE_MAX;
+        guarded(0);
+        for (auto& worker : workers) {
+            worker.join();
         }
-    }
-
-    return SIZE_MAX;
-}
-
-//----------------------------------------------------------------
-// findInsertBucket: Finds an empty bucket to insert a key using
-//             hash function and probing. Checks for duplicates.
-//    Returns:  bucket index if found, SIZE_MAX if duplicate or full (size_t)
-//    Parameters:
-//       key (string) - the key to insert
-//---------------------------------------------------------------
-size_t HashTable::findInsertBucket(const std::string& key) {
-    size_t home = hashFunction(key);
-    size_t cap = tableData.size();
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+    auto chunkBegin = [n, threadCount](size_t t) {
+        return n * t / threadCount;
+    };
 
-    if (tableData[home].isNormal() && tableData[home].getKey() == key) {
-        return SIZE_MAX;
+    // Hash and store each input chunk's keys, and count the pairs it
+    // sends to each thread
+    std::vector<BuildEntry> hashed(n);
+    std::vector<size_t> offsets(threadCount * threadCount, 0);   // [chunk * threadCount + owner]
+    std::vector<KeyArena> arenas;
+    arenas.reserve(threadCount);
+    for (size_t t = 0; t < threadCount; t++) {
+        arenas.emplace_back(table.memoryResource());
     }
-    if (tableData[home].isEmpty()) {
-        return home;
+    runParallel([&](size_t t) {
+        for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); i++) {
+            if (values[i] == 9999) {
+                continue;
+            }
+            uint64_t hash = table.hashKey(keys[i]);
+            hashed[i] = {table.homeBucket(hash, cap), i, storeKey(arenas[t], keys[i], hash)};
+            offsets[t * threadCount + hashed[i].home / rangeSize]++;
+        }
+    });
+    std::vector<uint32_t> arenaBase(threadCount);
+    for (size_t t = 0; t < threadCount; t++) {
+        arenaBase[t] = table.keyArena.adopt(std::move(arenas[t]));
     }
 
-    for (size_t i = 0; i < offsets.size(); i++) {
-        size_t probeIdx = (home + offsets[i]) % cap;
-
-        if (tableData[probeIdx].isNormal() && tableData[probeIdx].getKey() == key) {
-            return SIZE_MAX;
+    // Turn the counts into write positions: owners in order, and
+    // chunks in order within an owner, so input order is kept
+    std::vector<size_t> ownerStart(threadCount + 1, 0);
+    size_t position = 0;
+    for (size_t owner = 0; owner < threadCount; owner++) {
+        ownerStart[owner] = position;
+        for (size_t t = 0; t < threadCount; t++) {
+            size_t count = offsets[t * threadCount + owner];
+            offsets[t * threadCount + owner] = position;
+            position += count;
         }
+    }
+    ownerStart[threadCount] = position;
 
-        if (tableData[probeIdx].isEmpty()) {
-            return probeIdx;
+    std::vector<BuildEntry> order(position);
+    runParallel([&](size_t t) {
+        for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); i++) {
+            if (values[i] == 9999) {
+                continue;
+            }
+            HashTableBucket& bucket = hashed[i].bucket;
+            if (!bucket.isInline()) {
+                bucket.setArenaKey(bucket.keyOffset() + arenaBase[t], bucket.keyLength());
+            }
+            order[offsets[t * threadCount + hashed[i].home / rangeSize]++] = hashed[i];
         }
-    }
+    });
+    hashed = std::vector<BuildEntry>();
 
-    return SIZE_MAX;
-}
+    std::vector<size_t> placed(threadCount, 0);
+    std::vector<size_t> droppedBytes(threadCount, 0);
+    std::vector<std::vector<size_t>> dropped(threadCount);
+    runParallel([&](size_t owner) {
+        for (size_t k = ownerStart[owner]; k < ownerStart[owner + 1]; k++) {
+            const BuildEntry& entry = order[k];
+            std::string_view key(keys[entry.index]);
+            uint8_t tag = controlTag(entry.bucket.hash);
 
-//----------------------------------------------------------------
-// resize: Doubles the table size, rehashes elements when
-//             load factor reaches 0.5 or greater.
-//    Returns:  void
-//---------------------------------------------------------------
-void HashTable::resize() {
-    std::vector<HashTableBucket> oldData = tableData;
+            size_t bucketIdx = entry.home;
+            size_t step = 0;
+            bool isDuplicate = false;
+            while (true) {
+                std::atomic_ref<uint8_t> ctrl(table.control[bucketIdx]);
+                uint8_t seen = ctrl.load(std::memory_order_acquire);
+                if (seen == CTRL_EMPTY) {
+                    if (ctrl.compare_exchange_strong(seen, CTRL_DELETED, std::memory_order_relaxed)) {
+                        break;
+                    }
+                    continue;   // Another thread took it; look again
+                }
+                if (seen == tag && table.hasKey(table.tableData[bucketIdx], key, entry.bucket.hash)) {
+                    isDuplicate = true;
+                    break;
+                }
+                bucketIdx = table.nextProbe(bucketIdx, entry.bucket.hash, cap, step);
+            }
 
-    size_t newCapacity = tableData.size() * 2;
-    tableData.clear();
-    tableData.resize(newCapacity);
-    numElements = 0;
+            if (isDuplicate) {
+                dropped[owner].push_back(entry.index);
+                droppedBytes[owner] += entry.bucket.isInline() ? 0 : key.size();
+                continue;
+            }
+            table.tableData[bucketIdx] = entry.bucket;
+            table.valueData[bucketIdx] = values[entry.index];
+            std::atomic_ref<uint8_t>(table.control[bucketIdx]).store(tag, std::memory_order_release);
+            placed[owner]++;
+        }
+    });
 
-    generateOffsets(newCapacity);
+    table.numElements = std::accumulate(placed.begin(), placed.end(), size_t{0});
+    HT_STAT(table.counters.inserts = table.numElements);
+    table.deadKeyBytes = std::accumulate(droppedBytes.begin(), droppedBytes.end(), size_t{0});
+    if (table.deadKeyBytes * 2 > table.keyArena.usedBytes()) {
+        table.reclaimKeys();
+    }
 
-    for (const auto& bucket : oldData) {
-        if (bucket.isNormal()) {
-            insert(bucket.getKey(), bucket.getValue());
+    if (duplicates != nullptr) {
+        duplicates->clear();
+        for (const auto& part : dropped) {
+            duplicates->insert(duplicates->end(), part.begin(), part.end());
         }
+        std::sort(duplicates->begin(), duplicates->end());
     }
+    return table;
 }
 
 //----------------------------------------------------------------
-// insert: Inserts a key value pair into the table. Rejects
-//             duplicates and the reserved value 9999. Resizes
-//             table if load factor >= 0.5.
-//    Returns:  true if successful, false if duplicate or value is 9999 (bool)
+// buildFrom: Builds a table from many key value pairs at once on
+//             several threads. Same rules as a loop of insert():
+//             the first copy of a key is kept, later copies are
+//             duplicates, and pairs with the value 9999 are skipped.
+//             The table uses MIX64 and STOP_THE_WORLD resizing.
+//    Returns:  the filled table (HashTable)
 //    Parameters:
-//       key (string) - the key to insert
-//       value (size_t) - the value to associate with the key
+//       keys (span) - keys to insert
+//       values (span<const size_t>) - value for each key
+//       threadCount (size_t) - worker threads, 0 for one per core
+//       duplicates (vector<size_t>*) - if not null, receives the
+//             sorted indexes of pairs dropped as duplicates
 //---------------------------------------------------------------
-bool HashTable::insert(std::string key, size_t value) {
-    if (value == 9999) {
-        return false;
-    }
+HashTable HashTable::buildFrom(std::span<const std::string_view> keys, std::span<const size_t> values,
+                               size_t threadCount, std::vector<size_t>* duplicates) {
+    return buildFromImpl(keys, values, threadCount, duplicates);
+}
 
-    if (alpha() >= 0.5) {
-        resize();
-    }
+HashTable HashTable::buildFrom(std::span<const std::string> keys, std::span<const size_t> values,
+                               size_t threadCount, std::vector<size_t>* duplicates) {
+    return buildFromImpl(keys, values, threadCount, duplicates);
+}
 
-    size_t bucketIdx = findInsertBucket(key);
+//----------------------------------------------------------------
+// keys: Returns a vector containing all keys currently stored
+//             in the table. Copies every key; iterate the table or
+//             use forEach() to read keys and values without
+//             allocating.
+//    Returns:  vector of all keys (vector<string>)
+//---------------------------------------------------------------
+std::vector<string> HashTable::keys() const {
+    std::vector<string> result;
+    result.reserve(numElements);
 
-    if (bucketIdx == SIZE_MAX) {
-        return false;
-    }
+    forEach([&result](std::string_view key, size_t) {
+        result.emplace_back(key);
+    });
 
-    tableData[bucketIdx].load(key, value);
-    numElements++;
-    return true;
+    return result;
 }
 
 //----------------------------------------------------------------
-// remove: Removes a key value pair from the table by marking
-//             the bucket as EAR.
-//    Returns:  true if removed, false if key not found (bool)
+// iterator (constructor): Creates an iterator at a bucket that is
+//             NORMAL or the end position.
 //    Parameters:
-//       key (string) - the key to remove
+//       table (HashTable*) - table iterated
+//       index (size_t) - bucket index
+//       inOld (bool) - whether index is in the old array
 //---------------------------------------------------------------
-bool HashTable::remove(std::string key) {
-    size_t bucketIdx = findBucket(key);
+HashTable::iterator::iterator(HashTable* table, size_t index, bool inOld)
+    : table(table), index(index), inOld(inOld) {}
 
-    if (bucketIdx == SIZE_MAX) {
-        return false;
+//----------------------------------------------------------------
+// operator* (iterator): Returns the pair at the current bucket.
+//    Returns:  (key, reference to value) pair
+//---------------------------------------------------------------
+HashTable::iterator::reference HashTable::iterator::operator*() const {
+    if (inOld) {
+        return {table->keyOf(table->oldData[index]), table->oldValues[index]};
     }
+    return {table->keyOf(table->tableData[index]), table->valueData[index]};
+}
 
-    tableData[bucketIdx].makeEAR();
-    numElements--;
-    return true;
+//----------------------------------------------------------------
+// operator++ (iterator): Moves to the next stored pair.
+//    Returns:  this iterator (iterator&)
+//---------------------------------------------------------------
+HashTable::iterator& HashTable::iterator::operator++() {
+    index++;
+    table->advanceEntry(index, inOld);
+    return *this;
+}
+
+HashTable::iterator HashTable::iterator::operator++(int) {
+    iterator previous = *this;
+    ++*this;
+    return previous;
 }
 
 //----------------------------------------------------------------
-// contains: Checks if a key exists in the table.
-//    Returns:  true if key in table, false otherwise (bool)
+// const_iterator (constructor): Creates an iterator at a bucket
+//             that is NORMAL or the end position.
 //    Parameters:
-//       key (string) - the key to search for
+//       table (const HashTable*) - table iterated
+//       index (size_t) - bucket index
+//       inOld (bool) - whether index is in the old array
 //---------------------------------------------------------------
-bool HashTable::contains(const string& key) const {
-    return findBucket(key) != SIZE_MAX;
-}
+HashTable::const_iterator::const_iterator(const HashTable* table, size_t index, bool inOld)
+    : table(table), index(index), inOld(inOld) {}
 
 //----------------------------------------------------------------
-// get: Gets the value associated with a key.
-//    Returns:  value if found, std::nullopt if not found
+// const_iterator (converting constructor): Makes a read-only
+//             iterator at the same position as a mutable one.
 //    Parameters:
-//       key (string) - the key to search for
+//       other (const iterator&) - iterator to copy
 //---------------------------------------------------------------
-std::optional<size_t> HashTable::get(const string& key) const {
-    size_t bucketIdx = findBucket(key);
+HashTable::const_iterator::const_iterator(const iterator& other)
+    : table(other.table), index(other.index), inOld(other.inOld) {}
 
-    if (bucketIdx == SIZE_MAX) {
-        return std::nullopt;
+//----------------------------------------------------------------
+// operator* (const_iterator): Returns the pair at the current
+//             bucket.
+//    Returns:  (key, value) pair
+//---------------------------------------------------------------
+HashTable::const_iterator::reference HashTable::const_iterator::operator*() const {
+    if (inOld) {
+        return {table->keyOf(table->oldData[index]), table->oldValues[index]};
     }
+    return {table->keyOf(table->tableData[index]), table->valueData[index]};
+}
+
+//----------------------------------------------------------------
+// operator++ (const_iterator): Moves to the next stored pair.
+//    Returns:  this iterator (const_iterator&)
+//---------------------------------------------------------------
+HashTable::const_iterator& HashTable::const_iterator::operator++() {
+    index++;
+    table->advanceEntry(index, inOld);
+    return *this;
+}
 
-    return tableData[bucketIdx].getValue();
+HashTable::const_iterator HashTable::const_iterator::operator++(int) {
+    const_iterator previous = *this;
+    ++*this;
+    return previous;
 }
 
 //----------------------------------------------------------------
-// operator[]: Bracket operator. Returns reference for reading
-//   Undefined behavior if key not in table.
-//    Returns:  reference to value (size_t&)
-//    Parameters:
-//       key (string) - the key to access
+// begin: Returns an iterator at the first stored pair.
+//    Returns:  iterator, equal to end() if the table is empty
 //---------------------------------------------------------------
-size_t& HashTable::operator[](const string& key) {
-    size_t bucketIdx = findBucket(key);
-    return tableData[bucketIdx].getValueRef();
+HashTable::iterator HashTable::begin() {
+    size_t index = 0;
+    bool inOld = false;
+    advanceEntry(index, inOld);
+    return iterator(this, index, inOld);
 }
 
 //----------------------------------------------------------------
-// keys: Returns a vector containing all keys currently stored
-//             in the table.
-//    Returns:  vector of all keys (vector<string>)
+// end: Returns the iterator past the last stored pair.
+//    Returns:  iterator
 //---------------------------------------------------------------
-std::vector<string> HashTable::keys() const {
-    std::vector<string> result;
+HashTable::iterator HashTable::end() {
+    return iterator(this, oldData.size(), true);
+}
 
-    for (size_t i = 0; i < tableData.size(); i++) {
-        if (tableData[i].isNormal()) {
-            result.push_back(tableData[i].getKey());
-        }
-    }
+HashTable::const_iterator HashTable::begin() const {
+    return cbegin();
+}
 
-    return result;
+HashTable::const_iterator HashTable::end() const {
+    return cend();
+}
+
+//----------------------------------------------------------------
+// cbegin: Returns a read-only iterator at the first stored pair.
+//    Returns:  const_iterator, equal to cend() if the table is empty
+//---------------------------------------------------------------
+HashTable::const_iterator HashTable::cbegin() const {
+    size_t index = 0;
+    bool inOld = false;
+    advanceEntry(index, inOld);
+    return const_iterator(this, index, inOld);
+}
+
+//----------------------------------------------------------------
+// cend: Returns the read-only iterator past the last stored pair.
+//    Returns:  const_iterator
+//---------------------------------------------------------------
+HashTable::const_iterator HashTable::cend() const {
+    return const_iterator(this, oldData.size(), true);
 }
 
 //----------------------------------------------------------------
@@ -391,6 +2271,197 @@ size_t HashTable::size() const {
     return numElements;
 }
 
+//----------------------------------------------------------------
+// hashPolicy: Returns the hash policy this table was built with.
+//    Returns:  policy (HashPolicy)
+//---------------------------------------------------------------
+HashPolicy HashTable::hashPolicy() const {
+    return policy;
+}
+
+//----------------------------------------------------------------
+// tombstoneCount: Returns the number of EAR buckets in the table.
+//    Returns:  count (size_t)
+//---------------------------------------------------------------
+size_t HashTable::tombstoneCount() const {
+    return numRemoved;
+}
+
+//----------------------------------------------------------------
+// tombstoneRatio: Returns EAR buckets as a fraction of capacity.
+//    Returns:  ratio (double)
+//---------------------------------------------------------------
+double HashTable::tombstoneRatio() const {
+    return static_cast<double>(numRemoved) / static_cast<double>(tableData.size());
+}
+
+//----------------------------------------------------------------
+// setMaxTombstoneRatio: Sets the tombstone ratio above which
+//             remove() calls compact(). Default is 0.25.
+//    Returns:  void
+//    Parameters:
+//       ratio (double) - new limit, 1.0 or more disables it
+//---------------------------------------------------------------
+void HashTable::setMaxTombstoneRatio(double ratio) {
+    maxTombstoneRatio = ratio;
+}
+
+//----------------------------------------------------------------
+// isMigrating: Checks if an incremental resize is in progress.
+//    Returns:  true if the old array still holds buckets (bool)
+//---------------------------------------------------------------
+bool HashTable::isMigrating() const {
+    return !oldData.empty();
+}
+
+//----------------------------------------------------------------
+// migrationProgress: Reports how far the current incremental
+//             resize has got through the old array.
+//    Returns:  fraction of old buckets moved, 1.0 if idle (double)
+//---------------------------------------------------------------
+double HashTable::migrationProgress() const {
+    if (!isMigrating()) {
+        return 1.0;
+    }
+    return static_cast<double>(migrateIndex) / static_cast<double>(oldData.size());
+}
+
+//----------------------------------------------------------------
+// probeLength: Counts how many buckets a lookup of key examines,
+//             including the home bucket. Used for benchmarking.
+//    Returns:  number of buckets probed (size_t)
+//    Parameters:
+//       key (string_view) - the key to look up
+//---------------------------------------------------------------
+size_t HashTable::probeLength(std::string_view key) const {
+    uint64_t hash = hashKey(key);
+    size_t probes = 0;
+    if (findBucket(key, hash, &probes) == SIZE_MAX && isMigrating()) {
+        size_t oldProbes = 0;
+        findBucket(key, hash, &oldProbes, true);
+        probes += oldProbes;
+    }
+    return probes;
+}
+
+//----------------------------------------------------------------
+// stats: Builds a HashTableStats snapshot. Counters come from
+//             HASHTABLE_STATS builds only. Tombstones, bytes used
+//             and the longest probe chain (the most buckets any
+//             stored key needs to be found) are measured now, in
+//             O(n) time.
+//    Returns:  statistics (HashTableStats)
+//---------------------------------------------------------------
+HashTableStats HashTable::stats() const {
+#ifdef HASHTABLE_STATS
+    HashTableStats result = counters;
+#else
+    HashTableStats result;
+#endif
+
+    HashTableMemory memory = memoryUsage();
+    result.tombstones = numRemoved;
+    result.bucketBytes = memory.bucketBytes + memory.valueBytes;
+    result.keyBytes = memory.keyBytes;
+    result.controlBytes = memory.controlBytes;
+
+    size_t probes = 0;
+    for (size_t i = nextNormal(0); i < tableData.size(); i = nextNormal(i + 1)) {
+        findBucket(keyOf(tableData[i]), tableData[i].hash, &probes);
+        result.longestProbe = std::max(result.longestProbe, probes);
+    }
+    for (size_t i = nextNormal(migrateIndex, true); i < oldData.size(); i = nextNormal(i + 1, true)) {
+        findBucket(keyOf(oldData[i]), oldData[i].hash, &probes, true);
+        result.longestProbe = std::max(result.longestProbe, probes);
+    }
+
+#ifdef HASHTABLE_STATS
+    // The scan above went through findBucket; keep it out of the histogram
+    counters.probeHistogram = result.probeHistogram;
+#endif
+    return result;
+}
+
+//----------------------------------------------------------------
+// memoryUsage: Measures the bytes the table has allocated, by
+//             array. O(1): nothing is scanned.
+//    Returns:  memory breakdown (HashTableMemory)
+//---------------------------------------------------------------
+HashTableMemory HashTable::memoryUsage() const {
+    HashTableMemory memory;
+    memory.entries = numElements;
+    memory.controlBytes = control.capacity() + oldControl.capacity();
+    memory.bucketBytes = (tableData.capacity() + oldData.capacity()) * sizeof(HashTableBucket);
+    memory.valueBytes = (valueData.capacity() + oldValues.capacity()) * sizeof(size_t);
+    memory.keyBytes = keyArena.allocatedBytes();
+    memory.deadKeyBytes = deadKeyBytes;
+    return memory;
+}
+
+//----------------------------------------------------------------
+// memoryResource: Returns the resource the table allocates from.
+//    Returns:  the resource (memory_resource*)
+//---------------------------------------------------------------
+std::pmr::memory_resource* HashTable::memoryResource() const {
+    return tableData.get_allocator().resource();
+}
+
+//----------------------------------------------------------------
+// totalBytes: Adds up every array in the breakdown.
+//    Returns:  bytes (size_t)
+//---------------------------------------------------------------
+size_t HashTableMemory::totalBytes() const {
+    return controlBytes + bucketBytes + valueBytes + keyBytes;
+}
+
+//----------------------------------------------------------------
+// bytesPerEntry: Divides the total over the stored pairs.
+//    Returns:  bytes per entry, 0 for an empty table (double)
+//---------------------------------------------------------------
+double HashTableMemory::bytesPerEntry() const {
+    if (entries == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(totalBytes()) / static_cast<double>(entries);
+}
+
+//----------------------------------------------------------------
+// resetStats: Clears the operation counters, histogram and
+//             resize times. Does nothing without HASHTABLE_STATS.
+//    Returns:  void
+//---------------------------------------------------------------
+void HashTable::resetStats() {
+#ifdef HASHTABLE_STATS
+    counters = HashTableStats();
+#endif
+}
+
+#ifdef HASHTABLE_STATS
+//----------------------------------------------------------------
+// recordProbe: Adds one probe sequence length to the histogram.
+//    Returns:  void
+//    Parameters:
+//       probes (size_t) - buckets examined, at least 1
+//---------------------------------------------------------------
+void HashTable::recordProbe(size_t probes) const {
+    size_t slot = std::min(probes, HashTableStats::PROBE_HISTOGRAM_SIZE) - 1;
+    counters.probeHistogram[slot]++;
+}
+
+//----------------------------------------------------------------
+// recordResize: Counts a resize and how long it took.
+//    Returns:  void
+//    Parameters:
+//       start (time_point) - when the resize started
+//---------------------------------------------------------------
+void HashTable::recordResize(std::chrono::steady_clock::time_point start) {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    counters.resizes++;
+    counters.resizeNanos.push_back(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+#endif
+
 //----------------------------------------------------------------
 // printMe: Helper method that creates a string representation
 //             of the table showing all occupied buckets.
@@ -399,11 +2470,17 @@ size_t HashTable::size() const {
 std::string HashTable::printMe() const {
     std::string result = "";
 
-    for (size_t i = 0; i < tableData.size(); i++) {
-        if (tableData[i].isNormal()) {
-            result += "Bucket " + std::to_string(i) + ": <" +
-                      tableData[i].getKey() + ", " +
-                      std::to_string(tableData[i].getValue()) + ">\n";
+    for (size_t i = nextNormal(0); i < tableData.size(); i = nextNormal(i + 1)) {
+        result += "Bucket " + std::to_string(i) + ": <" +
+                  std::string(keyOf(tableData[i])) + ", " +
+                  std::to_string(valueData[i]) + ">\n";
+    }
+
+    for (size_t i = migrateIndex; i < oldData.size(); i++) {
+        if (oldControl[i] < CTRL_EMPTY) {
+            result += "Old bucket " + std::to_string(i) + ": <" +
+                      std::string(keyOf(oldData[i])) + ", " +
+                      std::to_string(oldValues[i]) + ">\n";
         }
     }
 
@@ -411,30 +2488,72 @@ std::string HashTable::printMe() const {
 }
 
 //----------------------------------------------------------------
-// operator<< (HashTableBucket):  operator for
-//             printing a bucket in format <key, value>.
-//    Returns:  output stream
+// operator<< (HashTable):  operator for printing
+//             the entire hash table by calling printMe().
+//    Returns:  output stream (ostream&)
 //    Parameters:
 //       os (ostream&) - output stream
-//       bucket (HashTableBucket&) - bucket to print
+//       hashTable (HashTable&) - hash table to print
 //---------------------------------------------------------------
-std::ostream& operator<<(std::ostream& os, const HashTableBucket& bucket) {
-    os << "<" << bucket.getKey() << ", " << bucket.getValue() << ">";
+std::ostream& operator<<(std::ostream& os, const HashTable& hashTable) {
+    os << hashTable.printMe();
     return os;
 }
 
 //----------------------------------------------------------------
-// operator<< (HashTable):  operator for printing
-//             the entire hash table by calling printMe().
+// operator<< (HashTableStats):  operator for printing table
+//             statistics, one field per line.
 //    Returns:  output stream (ostream&)
 //    Parameters:
 //       os (ostream&) - output stream
-//       hashTable (HashTable&) - hash table to print
+//       stats (HashTableStats&) - statistics to print
 //---------------------------------------------------------------
-std::ostream& operator<<(std::ostream& os, const HashTable& hashTable) {
-    os << hashTable.printMe();
+std::ostream& operator<<(std::ostream& os, const HashTableStats& stats) {
+    uint64_t resizeNanos = 0;
+    for (uint64_t ns : stats.resizeNanos) {
+        resizeNanos += ns;
+    }
+
+    os << "inserts: " << stats.inserts << "\n"
+       << "hits: " << stats.hits << "\n"
+       << "misses: " << stats.misses << "\n"
+       << "removes: " << stats.removes << "\n"
+       << "resizes: " << stats.resizes << " (" << resizeNanos / 1000 << " us)\n"
+       << "compactions: " << stats.compactions << "\n"
+       << "tombstones: " << stats.tombstones << "\n"
+       << "longest probe: " << stats.longestProbe << "\n"
+       << "bytes: buckets " << stats.bucketBytes << ", keys " << stats.keyBytes
+       << ", control " << stats.controlBytes << "\n"
+       << "probe histogram:";
+    for (size_t i = 0; i < stats.probeHistogram.size(); i++) {
+        if (stats.probeHistogram[i] != 0) {
+            os << " " << (i + 1) << (i + 1 == stats.probeHistogram.size() ? "+" : "")
+               << "=" << stats.probeHistogram[i];
+        }
+    }
     return os;
 }
 
+//----------------------------------------------------------------
+// operator<< (HashTableMemory):  operator for printing a memory
+//             breakdown, one array per line, with bytes per entry.
+//    Returns:  output stream (ostream&)
+//    Parameters:
+//       os (ostream&) - output stream
+//       memory (HashTableMemory&) - breakdown to print
+//---------------------------------------------------------------
+std::ostream& operator<<(std::ostream& os, const HashTableMemory& memory) {
+    double entries = memory.entries == 0 ? 1.0 : static_cast<double>(memory.entries);
+    auto line = [&](const char* name, size_t bytes) {
+        os << name << bytes << " (" << static_cast<double>(bytes) / entries << " per entry)\n";
+    };
 
-
+    os << "entries: " << memory.entries << "\n";
+    line("control: ", memory.controlBytes);
+    line("buckets: ", memory.bucketBytes);
+    line("values: ", memory.valueBytes);
+    line("keys: ", memory.keyBytes);
+    line("dead keys: ", memory.deadKeyBytes);
+    os << "total: " << memory.totalBytes() << " (" << memory.bytesPerEntry() << " per entry)";
+    return os;
+}
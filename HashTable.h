@@ -6,89 +6,525 @@
 #define HASHTABLE_H
 
 #include <string>
+#include <string_view>
+#include <span>
 #include <vector>
 #include <optional>
 #include <iostream>
+#include <cstdint>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#ifdef HASHTABLE_STATS
+#include <chrono>
+#endif
 
-enum class BucketType {
-    NORMAL,  // Has a key value pair
-    ESS,     // Empty Since Start
-    EAR      // Empty After Remove
+// HashPolicy selects how a key is turned into a 64-bit hash
+enum class HashPolicy {
+    MIX64,       // Fast 64-bit multiply-mix hash (wyhash style)
+    LEGACY_SUM   // Sum of ASCII values, kept for compatibility
 };
 
-// HashTableBucket stores a single key value pair
-// Each bucket also tracks its state (NORMAL, ESS, or EAR)
-class HashTableBucket {
-private:
-    std::string key;      // The key for this bucket
-    size_t value;         // The value associated with the key
-    BucketType type;      // Current state of the bucket
+// hashMix64 hashes a key with the MIX64 policy
+uint64_t hashMix64(std::string_view key);
 
-public:
-    // Constructor
-    HashTableBucket();
-    HashTableBucket(std::string key, size_t value);
+// ResizeMode selects how the table grows once it is half full
+enum class ResizeMode {
+    STOP_THE_WORLD,  // Rehash every element inside the insert that triggers growth
+    INCREMENTAL      // Keep the old array and move a few buckets per operation
+};
 
-    //Load method
-    void load(std::string key, size_t value);
+// GrowthPolicy selects the capacity the table grows to
+enum class GrowthPolicy {
+    DOUBLE,          // 2x the current capacity
+    ONE_AND_HALF,    // 1.5x: less memory per entry, more resizes
+    PRIME            // Smallest prime at least 2x the current capacity
+};
 
+// ProbePolicy selects where keys are placed and how remove() works
+enum class ProbePolicy {
+    DOUBLE_HASH,     // Per-hash probe step; remove() leaves an EAR tombstone
+    ROBIN_HOOD       // Linear probing kept in probe distance order; remove()
+                     // shifts the following keys back, so there are no tombstones
+};
 
+// HashTableBucket is the packed record kept for each bucket. Its
+// state (NORMAL, ESS or EAR) is the bucket's control byte and its
+// value is in a separate array, so the record itself is 16 bytes.
+// A key of up to INLINE_KEY_BYTES is stored in keyData, with
+// INLINE_FLAG | length in the last byte, and needs no arena lookup.
+// A longer key is stored in the table's key arena; keyData holds its
+// 32-bit offset, then its length little-endian, so the last byte is
+// the top of the length and has INLINE_FLAG clear.
+struct HashTableBucket {
+    static constexpr size_t INLINE_KEY_BYTES = 7;
+    static constexpr uint8_t INLINE_FLAG = 0x80;
 
-    // Getter methods
-    std::string getKey() const;   // Returns the key stored in this bucket
-    size_t getValue() const;       // Returns the value stored in this bucket
-    size_t& getValueRef();
+    uint64_t hash;        // Full hash of the key, cached at load time
+    char keyData[8];      // Inline key, or arena offset and length
 
-    // State checking methods
-    bool isNormal() const;
-    bool isEmpty() const;
-    bool isEmptySinceStart() const;
-    bool isEmptyAfterRemove() const;
+    bool isInline() const;
+    uint32_t keyOffset() const;
+    uint32_t keyLength() const;
+    void setInlineKey(std::string_view key);
+    void setArenaKey(uint32_t offset, uint32_t length);
+};
 
- // State changing methods
-    void makeNormal();
-    void makeESS();
-    void makeEAR();
 
+// HashTableStats is a snapshot returned by HashTable::stats().
+// The operation counters, probe histogram and resize times are only
+// collected when built with HASHTABLE_STATS; otherwise they stay 0
+// and the hot path has no extra work. The rest is measured from the
+// table when stats() is called.
+struct HashTableStats {
+    static constexpr size_t PROBE_HISTOGRAM_SIZE = 32;
 
-    friend std::ostream& operator<<(std::ostream& os, const HashTableBucket& bucket);
+    size_t inserts = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t removes = 0;
+    std::array<size_t, PROBE_HISTOGRAM_SIZE> probeHistogram{};  // [i] counts probes of length i + 1, last is 32+
+    size_t resizes = 0;
+    std::vector<uint64_t> resizeNanos;   // Time spent in each resize
+    size_t compactions = 0;
 
+    size_t tombstones = 0;
+    size_t longestProbe = 0;
+    size_t bucketBytes = 0;              // Bucket and value arrays, including an old array mid-migration
+    size_t keyBytes = 0;                 // Key arena
+    size_t controlBytes = 0;             // Control byte arrays
 };
 
+// HashTableMemory is the breakdown returned by HashTable::memoryUsage().
+// Every field is bytes allocated, counting unused vector capacity, and
+// includes the old arrays while an incremental resize is in progress.
+struct HashTableMemory {
+    size_t entries = 0;
+    size_t controlBytes = 0;             // One state byte per bucket
+    size_t bucketBytes = 0;              // Packed buckets: cached hash, key offset and length
+    size_t valueBytes = 0;               // Value arrays
+    size_t keyBytes = 0;                 // Key arena, including deadKeyBytes
+    size_t deadKeyBytes = 0;             // Arena bytes of removed keys not reclaimed yet
+
+    size_t totalBytes() const;
+    double bytesPerEntry() const;
+};
 
 class HashTable {
 private:
-    std::vector<HashTableBucket> tableData;
+    // KeyArena holds the bytes of every key too long to store inline.
+    // Keys are bump-allocated into chunks and never straddle one, so
+    // a 32-bit offset finds a key with one shift and one mask. The
+    // first chunk starts small and doubles up to CHUNK_BYTES; after
+    // that, growing allocates a new chunk and never moves a key.
+    // Chunks and the chunk index come from the arena's memory
+    // resource, and freeing the arena is one deallocate per chunk.
+    // Like a std::pmr container, a copy uses the default resource and
+    // an assignment keeps the target's resource.
+    class KeyArena {
+    public:
+        static constexpr size_t CHUNK_SHIFT = 16;
+        static constexpr size_t CHUNK_BYTES = size_t{1} << CHUNK_SHIFT;
+        static constexpr size_t FIRST_CHUNK_BYTES = 256;
+        // Offsets are 32 bits, so every key must end by this offset
+        static constexpr size_t MAX_BYTES = UINT32_MAX;
+
+        explicit KeyArena(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+        KeyArena(const KeyArena& other);
+        KeyArena(KeyArena&& other) noexcept;
+        KeyArena& operator=(const KeyArena& other);
+        KeyArena& operator=(KeyArena&& other);
+        ~KeyArena();
+
+        uint32_t append(std::string_view key);
+        uint32_t adopt(KeyArena&& other);
+        const char* at(uint32_t offset) const;
+        void clear();
+        size_t usedBytes() const;
+        size_t allocatedBytes() const;
+        bool holds(const char* p) const;
+        std::pmr::memory_resource* resource() const;
+
+    private:
+        struct Block {
+            char* data;
+            size_t bytes;
+        };
+
+        std::pmr::vector<Block> blocks;                // Allocations from resource()
+        std::pmr::vector<char*> chunks;                // Start of each CHUNK_BYTES of offsets
+        size_t used = 0;                               // Offset of the next key
+        size_t limit = 0;                              // End of the writable space at used
+        size_t allocated = 0;
+
+        void startChunk(size_t bytes);
+        void copyFrom(const KeyArena& other);
+    };
+
+    // Every array below, and the key arena, is allocated from the
+    // memory resource given to the constructor
+    std::pmr::vector<HashTableBucket> tableData;
+    std::pmr::vector<size_t> valueData;  // Value of each bucket in tableData
+    std::pmr::vector<uint8_t> control;   // One byte per bucket: CTRL_EMPTY, CTRL_DELETED or a 7-bit hash tag
+    KeyArena keyArena;              // Keys too long to inline, shared by tableData and oldData
+    size_t deadKeyBytes;            // Arena bytes no bucket refers to any more
     size_t numElements;
-    std::vector<size_t> offsets;
+    size_t numRemoved;              // EAR buckets in tableData
+    double maxTombstoneRatio;       // compact() once numRemoved / capacity passes this
+    HashPolicy policy;
+    uint64_t probeSeed;             // Picks the probe step for each hash; same seed, same layout
+    ResizeMode resizeMode;
+    double loadLimit;               // Grow once alpha() reaches this
+    GrowthPolicy growth;
+    ProbePolicy probing;
+
+    // Old bucket array kept alive while an incremental resize is
+    // in progress. Buckets before migrateIndex have been moved.
+    std::pmr::vector<HashTableBucket> oldData;
+    std::pmr::vector<size_t> oldValues;
+    std::pmr::vector<uint8_t> oldControl;
+    size_t migrateIndex;
+
+#ifdef HASHTABLE_STATS
+    // Counters updated from const lookups too. Not safe to share
+    // between threads that read the table at the same time.
+    mutable HashTableStats counters;
+    void recordProbe(size_t probes) const;
+    void recordResize(std::chrono::steady_clock::time_point start);
+#endif
+
+    // Keys hashed and prefetched together by the batch operations
+    static constexpr size_t BATCH_CHUNK = 32;
+
+    // Range setMaxLoadFactor() clamps to; open addressing needs empty buckets
+    static constexpr double MIN_LOAD_FACTOR = 0.1;
+    static constexpr double MAX_LOAD_FACTOR = 0.95;
+
+    // Fewest input pairs per thread worth starting a thread for in buildFrom()
+    static constexpr size_t BUILD_MIN_PER_THREAD = 16384;
+
+    // One input pair in buildFrom(), handed to the thread that owns
+    // its home bucket
+    struct BuildEntry {
+        size_t home;
+        size_t index;
+        HashTableBucket bucket;   // Arena keys are offsets into the hashing thread's arena until merged
+    };
+
+    // Old buckets examined per operation during an incremental resize
+    static constexpr size_t MIGRATE_STEP = 16;
+
+    // Control byte values for buckets that hold no data. NORMAL
+    // buckets store a 7-bit hash tag, so the high bit marks empty.
+    static constexpr uint8_t CTRL_EMPTY = 0x80;     // ESS
+    static constexpr uint8_t CTRL_DELETED = 0xFE;   // EAR
 
     //helpers
-    size_t hashFunction(const std::string& key) const;
-    void generateOffsets(size_t capacity);
-    size_t findInsertBucket(const std::string& key);
-    void resize();
-    size_t findBucket(const std::string& key) const;
+    std::string_view keyOf(const HashTableBucket& bucket) const;
+    bool hasKey(const HashTableBucket& bucket, std::string_view key, uint64_t hash) const;
+    static HashTableBucket storeKey(KeyArena& arena, std::string_view key, uint64_t hash);
+    void releaseKey(const HashTableBucket& bucket);
+    void reclaimKeys();
+    void moveBucket(size_t to, size_t from);
+    uint64_t hashKey(std::string_view key) const;
+    static uint64_t hashWith(std::string_view key, HashPolicy policy);
+    size_t homeBucket(uint64_t hash, size_t cap) const;
+    static uint8_t controlTag(uint64_t hash);
+    size_t nextNormal(size_t index, bool inOld = false) const;
+    void advanceEntry(size_t& index, bool& inOld) const;
+    size_t probeStep(uint64_t hash, size_t cap) const;
+    static size_t probeStepFor(uint64_t hash, size_t cap, uint64_t seed);
+    size_t nextProbe(size_t probeIdx, uint64_t hash, size_t cap, size_t& step) const;
+    size_t findInsertBucket(std::string_view key, uint64_t hash, size_t* existing = nullptr);
+    size_t probeDistance(uint64_t hash, size_t index, size_t cap) const;
+    size_t findRobinHoodBucket(std::string_view key, uint64_t hash, size_t* existing = nullptr);
+    void shiftForward(size_t index);
+    void shiftBackward(size_t index);
+    size_t findEmptyBucket(uint64_t hash) const;
+    void rehashInto(const HashTableBucket& bucket, size_t value);
+    size_t nextCapacity(size_t cap) const;
+    size_t minCapacityFor(size_t count) const;
+    void resize(size_t newCapacity);
+    void grow();
+    void beginMigration(size_t newCapacity);
+    void migrateStep(size_t budget);
+    void finishMigration();
+    size_t findBucket(std::string_view key, uint64_t hash, size_t* probeCount = nullptr, bool inOld = false) const;
+    const size_t* lookup(std::string_view key, uint64_t hash) const;
+    bool ownsKeyBytes(std::string_view key) const;
+    size_t prepareInsert(std::string_view& key, uint64_t hash, std::string& keyCopy, size_t** existing = nullptr);
+    size_t& findOrInsert(std::string_view key, uint64_t hash, size_t value, bool& inserted);
+    void prefetchHome(uint64_t hash) const;
+    template <typename KeyT>
+    void getBatchImpl(std::span<const KeyT> keys, std::span<std::optional<size_t>> out) const;
+    template <typename KeyT>
+    void containsBatchImpl(std::span<const KeyT> keys, std::span<bool> out) const;
+    template <typename KeyT>
+    size_t insertBatchImpl(std::span<const KeyT> keys, std::span<const size_t> values, std::span<bool> inserted);
+    template <typename KeyT>
+    static HashTable buildFromImpl(std::span<const KeyT> keys, std::span<const size_t> values,
+                                   size_t threadCount, std::vector<size_t>* duplicates);
+    void fillBucket(size_t bucketIdx, std::string_view key, size_t value, uint64_t hash);
+    bool removeHashed(std::string_view key, uint64_t hash);
+
+    // Shards call the hash-taking helpers so each key is hashed once
+    friend class ConcurrentHashTable;
+    // Snapshots read and write the bucket layout directly
+    friend class HashTableSnapshot;
+    // Frozen tables read buckets and cached hashes when they are built
+    friend class FrozenHashTable;
 
 
 public:
     static constexpr size_t DEFAULT_INITIAL_CAPACITY = 8;
 
-    HashTable(size_t initCapacity = 8);
-    bool insert(std::string key, size_t value);
-    bool remove(std::string key);
-    bool contains(const std::string& key) const;
-    std::optional<size_t> get(const std::string& key) const;
-    size_t& operator[](const std::string& key);
+    // Iterators over the stored pairs: tableData in bucket order, then
+    // the old array of an incremental resize. Dereferencing gives a
+    // (key, value) pair by value; the key view points into the table,
+    // and so does the value for a mutable iterator. Iterating
+    // allocates nothing. Any insert or remove invalidates every
+    // iterator and key view; insert() copies a key view taken from
+    // this table before it can move, so passing one back is safe.
+    class iterator {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<std::string_view, size_t>;
+        using reference = std::pair<std::string_view, size_t&>;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        reference operator*() const;
+        iterator& operator++();
+        iterator operator++(int);
+        bool operator==(const iterator& other) const = default;
+
+    private:
+        HashTable* table = nullptr;
+        size_t index = 0;
+        bool inOld = false;
+
+        iterator(HashTable* table, size_t index, bool inOld);
+        friend class HashTable;
+    };
+
+    class const_iterator {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<std::string_view, size_t>;
+        using reference = value_type;
+        using difference_type = std::ptrdiff_t;
+
+        const_iterator() = default;
+        const_iterator(const iterator& other);
+        reference operator*() const;
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        bool operator==(const const_iterator& other) const = default;
+
+    private:
+        const HashTable* table = nullptr;
+        size_t index = 0;
+        bool inOld = false;
+
+        const_iterator(const HashTable* table, size_t index, bool inOld);
+        friend class HashTable;
+    };
+
+    // memory supplies the bucket arrays, control bytes and key arena,
+    // e.g. a std::pmr::monotonic_buffer_resource for a short-lived
+    // table or a HugePageResource for a large one. It must outlive
+    // the table. Like a std::pmr container, a copy of the table uses
+    // the default resource and an assignment keeps the target's.
+    HashTable(size_t initCapacity = 8, HashPolicy policy = HashPolicy::MIX64,
+              ResizeMode resizeMode = ResizeMode::STOP_THE_WORLD,
+              uint64_t probeSeed = 0,
+              std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    bool insert(std::string_view key, size_t value);
+    bool insert(std::string&& key, size_t value);
+    bool insert(const char* key, size_t value);
+    bool remove(std::string_view key);
+    bool contains(std::string_view key) const;
+    std::optional<size_t> get(std::string_view key) const;
+    size_t& operator[](std::string_view key);
+
+    // Single-probe updates: each hashes the key once and walks one
+    // probe sequence, inserting into the bucket that walk found if
+    // the key is missing. Unlike insert(), any value may be stored.
+    bool insertOrAssign(std::string_view key, size_t value);
+    std::pair<size_t&, bool> tryEmplace(std::string_view key, size_t value = 0);
+    size_t& getOrInsert(std::string_view key, size_t defaultValue = 0);
+    size_t fetchAdd(std::string_view key, size_t delta);
     std::vector<std::string> keys() const;
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+
+    // Calls callback(string_view key, size_t& value) for every pair,
+    // skipping empty buckets a control byte group at a time
+    template <typename Callback>
+    void forEach(Callback&& callback);
+    template <typename Callback>
+    void forEach(Callback&& callback) const;
+
+    // Batch operations: out[i] / inserted[i] is the result for keys[i].
+    // Output spans must be at least keys.size() long; inserted may be empty.
+    void getBatch(std::span<const std::string_view> keys, std::span<std::optional<size_t>> out) const;
+    void getBatch(std::span<const std::string> keys, std::span<std::optional<size_t>> out) const;
+    void containsBatch(std::span<const std::string_view> keys, std::span<bool> out) const;
+    void containsBatch(std::span<const std::string> keys, std::span<bool> out) const;
+    size_t insertBatch(std::span<const std::string_view> keys, std::span<const size_t> values,
+                       std::span<bool> inserted = {});
+    size_t insertBatch(std::span<const std::string> keys, std::span<const size_t> values,
+                       std::span<bool> inserted = {});
+
+    // Bulk build: sizes the table once and fills it from threadCount
+    // threads (0 = one per core). The first copy of a key wins, like a
+    // loop of insert(); indexes of later copies go to duplicates.
+    static HashTable buildFrom(std::span<const std::string_view> keys, std::span<const size_t> values,
+                               size_t threadCount = 0, std::vector<size_t>* duplicates = nullptr);
+    static HashTable buildFrom(std::span<const std::string> keys, std::span<const size_t> values,
+                               size_t threadCount = 0, std::vector<size_t>* duplicates = nullptr);
     double alpha() const;
     size_t capacity() const;
     size_t size() const;
+    HashPolicy hashPolicy() const;
+    size_t tombstoneCount() const;
+    double tombstoneRatio() const;
+    void setMaxTombstoneRatio(double ratio);
+    void compact();
+    void clear();
+    void reserve(size_t count);
+    void rehash(size_t buckets);
+    double maxLoadFactor() const;
+    void setMaxLoadFactor(double loadFactor);
+    GrowthPolicy growthPolicy() const;
+    void setGrowthPolicy(GrowthPolicy growthPolicy);
+    ProbePolicy probePolicy() const;
+    void setProbePolicy(ProbePolicy probePolicy);
+    bool isMigrating() const;
+    double migrationProgress() const;
+    size_t probeLength(std::string_view key) const;
+    HashTableStats stats() const;
+    void resetStats();
+    HashTableMemory memoryUsage() const;
+    std::pmr::memory_resource* memoryResource() const;
+
+    // Binary snapshot of the bucket layout; see HashTableSnapshot.h
+    bool saveSnapshot(const std::string& path) const;
+    static std::optional<HashTable> openSnapshot(const std::string& path);
 
     std::string printMe() const;
 
 
 };
+//----------------------------------------------------------------
+// The key accessors below are defined here, not in HashTable.cpp,
+// so that forEach() and the iterators inline them.
+//---------------------------------------------------------------
+
+//----------------------------------------------------------------
+// isInline: Checks if the key is stored in the bucket itself.
+//    Returns:  true if inline, false if in the key arena (bool)
+//---------------------------------------------------------------
+inline bool HashTableBucket::isInline() const {
+    return (static_cast<uint8_t>(keyData[7]) & INLINE_FLAG) != 0;
+}
+
+//----------------------------------------------------------------
+// keyOffset: Returns where an arena key starts in the key arena.
+//    Returns:  offset (uint32_t)
+//---------------------------------------------------------------
+inline uint32_t HashTableBucket::keyOffset() const {
+    uint32_t offset;
+    std::memcpy(&offset, keyData, sizeof(offset));
+    return offset;
+}
+
+//----------------------------------------------------------------
+// keyLength: Returns the length of the key, inline or not.
+//    Returns:  length in bytes (uint32_t)
+//---------------------------------------------------------------
+inline uint32_t HashTableBucket::keyLength() const {
+    if (isInline()) {
+        return static_cast<uint8_t>(keyData[7]) & ~INLINE_FLAG;
+    }
+    return static_cast<uint32_t>(static_cast<uint8_t>(keyData[4])) |
+           static_cast<uint32_t>(static_cast<uint8_t>(keyData[5])) << 8 |
+           static_cast<uint32_t>(static_cast<uint8_t>(keyData[6])) << 16 |
+           static_cast<uint32_t>(static_cast<uint8_t>(keyData[7])) << 24;
+}
+
+//----------------------------------------------------------------
+// at: Finds the bytes at an offset returned by append().
+//    Returns:  pointer to the key's first byte (const char*)
+//    Parameters:
+//       offset (uint32_t) - offset of the key
+//---------------------------------------------------------------
+inline const char* HashTable::KeyArena::at(uint32_t offset) const {
+    return chunks[offset >> CHUNK_SHIFT] + (offset & (CHUNK_BYTES - 1));
+}
+
+//----------------------------------------------------------------
+// keyOf: Returns the key of a NORMAL bucket, from the bucket itself
+//             or from the key arena. The view is valid until the
+//             next insert or remove.
+//    Returns:  key (string_view)
+//    Parameters:
+//       bucket (const HashTableBucket&) - bucket in tableData or oldData
+//---------------------------------------------------------------
+inline std::string_view HashTable::keyOf(const HashTableBucket& bucket) const {
+    if (bucket.isInline()) {
+        return std::string_view(bucket.keyData, bucket.keyLength());
+    }
+    return std::string_view(keyArena.at(bucket.keyOffset()), bucket.keyLength());
+}
+
+//----------------------------------------------------------------
+// forEach: Calls callback(key, value) for every stored pair. Empty
+//             buckets are skipped by scanning control bytes, and
+//             the value is passed by reference so it can be
+//             updated in place. The callback must not insert or
+//             remove.
+//    Returns:  void
+//    Parameters:
+//       callback (Callback&&) - called as callback(string_view, size_t&)
+//---------------------------------------------------------------
+template <typename Callback>
+void HashTable::forEach(Callback&& callback) {
+    for (size_t i = nextNormal(0); i < tableData.size(); i = nextNormal(i + 1)) {
+        callback(keyOf(tableData[i]), valueData[i]);
+    }
+    for (size_t i = nextNormal(migrateIndex, true); i < oldData.size(); i = nextNormal(i + 1, true)) {
+        callback(keyOf(oldData[i]), oldValues[i]);
+    }
+}
+
+//----------------------------------------------------------------
+// forEach (const): Same as forEach(), with the value passed by
+//             value.
+//    Returns:  void
+//    Parameters:
+//       callback (Callback&&) - called as callback(string_view, size_t)
+//---------------------------------------------------------------
+template <typename Callback>
+void HashTable::forEach(Callback&& callback) const {
+    for (size_t i = nextNormal(0); i < tableData.size(); i = nextNormal(i + 1)) {
+        callback(keyOf(tableData[i]), valueData[i]);
+    }
+    for (size_t i = nextNormal(migrateIndex, true); i < oldData.size(); i = nextNormal(i + 1, true)) {
+        callback(keyOf(oldData[i]), oldValues[i]);
+    }
+}
+
 std::ostream& operator<<(std::ostream& os, const HashTable& hashTable);
-std::ostream& operator<<(std::ostream& os, const HashTableBucket& bucket);
+std::ostream& operator<<(std::ostream& os, const HashTableStats& stats);
+std::ostream& operator<<(std::ostream& os, const HashTableMemory& memory);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,1589 @@
+/**
+ * HashTableBench.cpp
+ *
+ * Benchmarks for the HashTable. Reports probe lengths for each
+ * hash policy over several key sets, per-insert latency for
+ * each resize mode, allocations made while growing, and 64-bit
+ * ID keys in FlatHashTable versus the same IDs as strings, and
+ * get() in a loop versus getBatch().
+ *
+ * "HashTableBench ops [maxSize] [csv|json]" instead times every
+ * operation for table sizes 1K up to maxSize (default 1M, at most
+ * 100M) over four key profiles, against std::unordered_map, and
+ * prints machine-readable rows.
+ *
+ * "HashTableBench concurrent [maxThreads]" measures throughput of
+ * ConcurrentHashTable and OptimisticHashTable against one HashTable
+ * behind a global mutex for 1 up to maxThreads (default 64) threads
+ * and several read ratios, and prints CSV.
+ *
+ * "HashTableBench build [count] [maxThreads]" times building a table
+ * of count pairs (default 5M) with a loop of insert() and with
+ * HashTable::buildFrom() on 1 up to maxThreads threads, as CSV.
+ *
+ * "HashTableBench load [count]" inserts count keys (default 1M) for
+ * each growth policy and max load factor 0.5 to 0.9, with and
+ * without reserve(), and prints the memory / probe length trade-off
+ * as CSV.
+ *
+ * "HashTableBench snapshot [count] [path]" saves a table of count
+ * keys (default 1M) as a binary snapshot and times loading it back
+ * against inserting every key again.
+ *
+ * "HashTableBench frozen [count]" compares a FrozenHashTable built
+ * from a HashTable of count keys (default 1M) with the HashTable.
+ *
+ * "HashTableBench robin [count]" compares the DOUBLE_HASH and
+ * ROBIN_HOOD probe policies at load factors 0.5 to 0.9 with count
+ * keys (default 1M), before and after a round of removes and
+ * inserts, and prints CSV.
+ *
+ * "HashTableBench cuckoo [count]" times inserts and single lookups in
+ * CuckooHashTable against HashTable with each probe policy, with
+ * count keys (default 1M), and reports the lookup latency tail.
+ *
+ * "HashTableBench scan [count]" sums every value of a table of count
+ * keys (default 1M) three ways: keys() then get() on each key,
+ * range-for over the table, and forEach(), with time and
+ * allocations for each.
+ *
+ * "HashTableBench counter [events] [distinct]" counts a Zipf stream
+ * of events (default 10M) over distinct keys (default 1M) with
+ * contains() then insert() or operator[], and with fetchAdd().
+ *
+ * "HashTableBench memory [count]" prints memoryUsage() per entry for
+ * count numeric keys and count ID keys (default 1M).
+ *
+ * "HashTableBench alloc [count] [requests]" compares memory
+ * resources: requests short-lived 64-key tables (default 100K) on
+ * the global heap and on a stack buffer, then one table of count
+ * keys (default 1M) on the global heap, a monotonic arena and huge
+ * pages.
+ */
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <new>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <optional>
+#include <span>
+#include <mutex>
+#include <thread>
+#include <memory_resource>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+#include "HashTable.h"
+#include "HashTableSnapshot.h"
+#include "FrozenHashTable.h"
+#include "CuckooHashTable.h"
+#include "FlatHashTable.h"
+#include "ConcurrentHashTable.h"
+#include "OptimisticHashTable.h"
+#include "HugePageResource.h"
+#include "HashTableBenchAlloc.h"
+using namespace std;
+
+//----------------------------------------------------------------
+// makeIdKeys: Builds ID-like keys that share a long prefix,
+//             e.g. "order-2024-0000001234".
+//    Returns:  vector of keys
+//    Parameters:
+//       count (size_t) - number of keys to build
+//---------------------------------------------------------------
+vector<string> makeIdKeys(size_t count) {
+    vector<string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        string digits = to_string(i);
+        keys.push_back("order-2024-" + string(10 - min<size_t>(10, digits.size()), '0') + digits);
+    }
+    return keys;
+}
+
+//----------------------------------------------------------------
+// makeNumericKeys: Builds short keys "1", "2", ... like the tests.
+//    Returns:  vector of keys
+//    Parameters:
+//       count (size_t) - number of keys to build
+//---------------------------------------------------------------
+vector<string> makeNumericKeys(size_t count) {
+    vector<string> keys;
+    keys.reserve(count);
+    for (size_t i = 1; i <= count; i++) {
+        keys.push_back(to_string(i));
+    }
+    return keys;
+}
+
+//----------------------------------------------------------------
+// makeAnagramKeys: Builds keys that are all permutations of the
+//             same letters, so they share a character sum.
+//    Returns:  vector of keys
+//    Parameters:
+//       count (size_t) - number of keys to build
+//---------------------------------------------------------------
+vector<string> makeAnagramKeys(size_t count) {
+    vector<string> keys;
+    keys.reserve(count);
+    string word = "abcdefghijk";
+    while (keys.size() < count) {
+        keys.push_back(word);
+        if (!next_permutation(word.begin(), word.end())) {
+            break;
+        }
+    }
+    return keys;
+}
+
+//----------------------------------------------------------------
+// runProbeBenchmark: Inserts every key with the given policy and
+//             prints insert time plus average and max probe length
+//             for successful lookups.
+//    Returns:  void
+//    Parameters:
+//       setName (string) - label for the key set
+//       keys (vector<string>) - keys to insert
+//       policy (HashPolicy) - hash policy under test
+//---------------------------------------------------------------
+void runProbeBenchmark(const string& setName, const vector<string>& keys, HashPolicy policy) {
+    HashTable table(HashTable::DEFAULT_INITIAL_CAPACITY, policy);
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i++) {
+        table.insert(keys[i], i);
+    }
+    auto stop = chrono::steady_clock::now();
+    double insertMs = chrono::duration<double, milli>(stop - start).count();
+
+    size_t totalProbes = 0;
+    size_t maxProbes = 0;
+    for (const auto& key : keys) {
+        size_t probes = table.probeLength(key);
+        totalProbes += probes;
+        maxProbes = max(maxProbes, probes);
+    }
+    double avgProbes = static_cast<double>(totalProbes) / static_cast<double>(keys.size());
+
+    cout << left << setw(10) << setName
+         << setw(12) << (policy == HashPolicy::MIX64 ? "MIX64" : "LEGACY_SUM")
+         << right << setw(10) << keys.size()
+         << setw(12) << fixed << setprecision(2) << avgProbes
+         << setw(10) << maxProbes
+         << setw(14) << setprecision(1) << insertMs << endl;
+}
+
+//----------------------------------------------------------------
+// runResizeLatencyBenchmark: Times every single insert with the
+//             given resize mode and prints total time plus the
+//             p99 and worst insert latency.
+//    Returns:  void
+//    Parameters:
+//       keys (vector<string>) - keys to insert
+//       mode (ResizeMode) - resize mode under test
+//---------------------------------------------------------------
+void runResizeLatencyBenchmark(const vector<string>& keys, ResizeMode mode) {
+    HashTable table(HashTable::DEFAULT_INITIAL_CAPACITY, HashPolicy::MIX64, mode);
+    vector<double> latencies;
+    latencies.reserve(keys.size());
+
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i++) {
+        auto before = chrono::steady_clock::now();
+        table.insert(keys[i], i);
+        auto after = chrono::steady_clock::now();
+        latencies.push_back(chrono::duration<double, micro>(after - before).count());
+    }
+    auto stop = chrono::steady_clock::now();
+    double totalMs = chrono::duration<double, milli>(stop - start).count();
+
+    sort(latencies.begin(), latencies.end());
+    double p99 = latencies[latencies.size() * 99 / 100];
+    double worst = latencies.back();
+
+    cout << left << setw(16) << (mode == ResizeMode::INCREMENTAL ? "INCREMENTAL" : "STOP_THE_WORLD")
+         << right << setw(10) << keys.size()
+         << setw(14) << fixed << setprecision(1) << totalMs
+         << setw(12) << setprecision(2) << p99
+         << setw(14) << setprecision(1) << worst << endl;
+}
+
+//----------------------------------------------------------------
+// runGrowthBenchmark: Grows a table from the default capacity to
+//             hold every key and prints wall time, the number of
+//             resizes, and allocations made by the table beyond
+//             the one copy of each key that insert() takes.
+//    Returns:  void
+//    Parameters:
+//       keys (vector<string>) - keys to insert
+//---------------------------------------------------------------
+void runGrowthBenchmark(const vector<string>& keys) {
+    HashTable table(HashTable::DEFAULT_INITIAL_CAPACITY);
+    size_t resizes = 0;
+    size_t keyCopies = 0;
+
+    size_t allocsBefore = allocationCount;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i++) {
+        size_t cap = table.capacity();
+        size_t allocsBeforeCopy = allocationCount;
+        string key = keys[i];
+        keyCopies += allocationCount - allocsBeforeCopy;
+        table.insert(move(key), i);
+        if (table.capacity() != cap) {
+            resizes++;
+        }
+    }
+    auto stop = chrono::steady_clock::now();
+    size_t tableAllocs = allocationCount - allocsBefore - keyCopies;
+    double totalMs = chrono::duration<double, milli>(stop - start).count();
+
+    cout << right << setw(10) << keys.size()
+         << setw(12) << table.capacity()
+         << setw(10) << resizes
+         << setw(14) << tableAllocs
+         << setw(14) << fixed << setprecision(1) << totalMs << endl;
+}
+
+//----------------------------------------------------------------
+// runIntegerKeyBenchmark: Inserts and looks up count 64-bit IDs,
+//             once in FlatHashTable and once in HashTable as
+//             decimal strings. Prints time and bytes per entry,
+//             counting the bucket arrays plus the key arena.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of IDs
+//---------------------------------------------------------------
+void runIntegerKeyBenchmark(size_t count) {
+    vector<uint64_t> ids;
+    ids.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        ids.push_back(i * 0x9E3779B97F4A7C15ULL);
+    }
+
+    FlatHashTable<uint64_t, size_t> flat;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        flat.insert(ids[i], i);
+    }
+    size_t found = 0;
+    for (size_t i = 0; i < count; i++) {
+        found += flat.contains(ids[i]);
+    }
+    auto stop = chrono::steady_clock::now();
+    double flatMs = chrono::duration<double, milli>(stop - start).count();
+    double flatBytes = static_cast<double>(flat.capacity() * (sizeof(FlatHashTable<uint64_t, size_t>::Slot) + 1)) / count;
+
+    HashTable table;
+    start = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        table.insert(to_string(ids[i]), i);
+    }
+    for (size_t i = 0; i < count; i++) {
+        found += table.contains(to_string(ids[i]));
+    }
+    stop = chrono::steady_clock::now();
+    double stringMs = chrono::duration<double, milli>(stop - start).count();
+    double stringBytes = table.memoryUsage().bytesPerEntry();
+
+    cout << left << setw(22) << "FlatHashTable<u64>" << right << setw(10) << count
+         << setw(14) << fixed << setprecision(1) << flatMs
+         << setw(14) << flatBytes << endl;
+    cout << left << setw(22) << "HashTable (string)" << right << setw(10) << count
+         << setw(14) << stringMs
+         << setw(14) << stringBytes << endl;
+    if (found < count) {
+        cout << "lookup mismatch" << endl;
+    }
+}
+
+//----------------------------------------------------------------
+// runBatchBenchmark: Looks up every key of a count-key table in
+//             random order, in requests of 64 keys, once with get()
+//             per key and once with getBatch() per request.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of keys in the table
+//---------------------------------------------------------------
+void runBatchBenchmark(size_t count) {
+    vector<string> keys = makeIdKeys(count);
+    HashTable table;
+    for (size_t i = 0; i < count; i++) {
+        table.insert(keys[i], i + 10000);
+    }
+    shuffle(keys.begin(), keys.end(), mt19937_64(7));
+
+    constexpr size_t REQUEST = 64;
+    vector<optional<size_t>> out(REQUEST);
+    size_t sum = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (const auto& key : keys) {
+        sum += table.get(key).value_or(0);
+    }
+    auto stop = chrono::steady_clock::now();
+    double singleNs = chrono::duration<double, nano>(stop - start).count() / count;
+
+    start = chrono::steady_clock::now();
+    for (size_t base = 0; base < keys.size(); base += REQUEST) {
+        size_t n = min(REQUEST, keys.size() - base);
+        span<const string> request(keys.data() + base, n);
+        table.getBatch(request, span<optional<size_t>>(out.data(), n));
+        for (size_t j = 0; j < n; j++) {
+            sum -= out[j].value_or(0);
+        }
+    }
+    stop = chrono::steady_clock::now();
+    double batchNs = chrono::duration<double, nano>(stop - start).count() / count;
+
+    cout << right << setw(10) << count
+         << setw(14) << fixed << setprecision(1) << singleNs
+         << setw(14) << batchNs
+         << (sum == 0 ? "" : "  (mismatch)") << endl;
+}
+
+//----------------------------------------------------------------
+// Operation sweep ("HashTableBench ops"): times every public
+// operation over several key profiles and table sizes, for
+// HashTable and std::unordered_map, and prints one CSV or JSON
+// row per measurement.
+//---------------------------------------------------------------
+
+// Sink for lookup results so the compiler cannot drop the loops
+static volatile size_t benchSink = 0;
+
+// KeyProfile is one key set plus the order lookups visit it in
+struct KeyProfile {
+    string name;
+    vector<string> keys;        // keys inserted into the table
+    vector<string> missKeys;    // keys never inserted, same shape
+    vector<size_t> lookupOrder; // indexes into keys for hit lookups
+};
+
+// BenchRow is one measurement in the output
+struct BenchRow {
+    string table;
+    string profile;
+    string op;
+    size_t n;
+    size_t ops;
+    double totalNs;
+};
+
+//----------------------------------------------------------------
+// peakRssKb: Returns the peak resident set size of the process.
+//    Returns:  peak RSS in KiB, 0 if not available (size_t)
+//---------------------------------------------------------------
+size_t peakRssKb() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<size_t>(usage.ru_maxrss) / 1024;
+#else
+    return static_cast<size_t>(usage.ru_maxrss);
+#endif
+#else
+    return 0;
+#endif
+}
+
+//----------------------------------------------------------------
+// timeNs: Runs body once and returns how long it took.
+//    Returns:  elapsed nanoseconds (double)
+//    Parameters:
+//       body (callable) - the work to time
+//---------------------------------------------------------------
+template <typename Body>
+double timeNs(Body&& body) {
+    auto start = chrono::steady_clock::now();
+    body();
+    auto stop = chrono::steady_clock::now();
+    return chrono::duration<double, nano>(stop - start).count();
+}
+
+//----------------------------------------------------------------
+// makeRandomKeys: Builds random alphanumeric keys of one length.
+//    Returns:  vector of keys
+//    Parameters:
+//       count (size_t) - number of keys to build
+//       length (size_t) - characters per key
+//       rng (mt19937_64&) - random source
+//---------------------------------------------------------------
+vector<string> makeRandomKeys(size_t count, size_t length, mt19937_64& rng) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    vector<string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        string key(length, ' ');
+        for (char& c : key) {
+            c = alphabet[rng() % (sizeof(alphabet) - 1)];
+        }
+        keys.push_back(std::move(key));
+    }
+    return keys;
+}
+
+//----------------------------------------------------------------
+// makeZipfOrder: Draws count ranks in [0, n) from a Zipf
+//             distribution with exponent theta (YCSB method), then
+//             maps ranks to key indexes with a fixed shuffle so the
+//             hot keys are spread through the key set.
+//    Returns:  vector of key indexes
+//    Parameters:
+//       n (size_t) - number of keys
+//       count (size_t) - number of draws
+//       theta (double) - skew, 0.99 is the YCSB default
+//       rng (mt19937_64&) - random source
+//---------------------------------------------------------------
+vector<size_t> makeZipfOrder(size_t n, size_t count, double theta, mt19937_64& rng) {
+    double zetan = 0.0;
+    for (size_t i = 1; i <= n; i++) {
+        zetan += 1.0 / pow(static_cast<double>(i), theta);
+    }
+    double zeta2 = 1.0 + 1.0 / pow(2.0, theta);
+    double alpha = 1.0 / (1.0 - theta);
+    double eta = (1.0 - pow(2.0 / static_cast<double>(n), 1.0 - theta)) / (1.0 - zeta2 / zetan);
+
+    vector<size_t> rankToKey(n);
+    iota(rankToKey.begin(), rankToKey.end(), 0);
+    shuffle(rankToKey.begin(), rankToKey.end(), rng);
+
+    uniform_real_distribution<double> unit(0.0, 1.0);
+    vector<size_t> order;
+    order.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        double u = unit(rng);
+        double uz = u * zetan;
+        size_t rank;
+        if (uz < 1.0) {
+            rank = 0;
+        } else if (uz < zeta2) {
+            rank = 1;
+        } else {
+            rank = static_cast<size_t>(static_cast<double>(n) * pow(eta * u - eta + 1.0, alpha));
+        }
+        order.push_back(rankToKey[min(rank, n - 1)]);
+    }
+    return order;
+}
+
+//----------------------------------------------------------------
+// makeUniformOrder: Draws count key indexes uniformly from [0, n).
+//    Returns:  vector of key indexes
+//    Parameters:
+//       n (size_t) - number of keys
+//       count (size_t) - number of draws
+//       rng (mt19937_64&) - random source
+//---------------------------------------------------------------
+vector<size_t> makeUniformOrder(size_t n, size_t count, mt19937_64& rng) {
+    vector<size_t> order;
+    order.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        order.push_back(rng() % n);
+    }
+    return order;
+}
+
+//----------------------------------------------------------------
+// makeProfiles: Builds the four key profiles for n keys:
+//             uniform (random 16-char keys, uniform lookups),
+//             zipf (same keys, Zipf 0.99 lookups), prefix (IDs
+//             behind a 32-char shared prefix) and anagram
+//             (permutations of one word, all with equal sums).
+//    Returns:  vector of profiles
+//    Parameters:
+//       n (size_t) - keys per profile
+//---------------------------------------------------------------
+vector<KeyProfile> makeProfiles(size_t n) {
+    mt19937_64 rng(42);
+    vector<KeyProfile> profiles;
+
+    vector<string> randomKeys = makeRandomKeys(2 * n, 16, rng);
+    vector<string> hitKeys(randomKeys.begin(), randomKeys.begin() + n);
+    vector<string> missKeys(randomKeys.begin() + n, randomKeys.end());
+    randomKeys.clear();
+    randomKeys.shrink_to_fit();
+
+    profiles.push_back({"uniform", hitKeys, missKeys, makeUniformOrder(n, n, rng)});
+    profiles.push_back({"zipf", std::move(hitKeys), std::move(missKeys), makeZipfOrder(n, n, 0.99, rng)});
+
+    const string prefix = "tenant/acme-corp/region/us-east/";
+    vector<string> prefixKeys = makeIdKeys(2 * n);
+    for (auto& key : prefixKeys) {
+        key.insert(0, prefix);
+    }
+    profiles.push_back({"prefix",
+                        vector<string>(prefixKeys.begin(), prefixKeys.begin() + n),
+                        vector<string>(prefixKeys.begin() + n, prefixKeys.end()),
+                        makeUniformOrder(n, n, rng)});
+    prefixKeys.clear();
+    prefixKeys.shrink_to_fit();
+
+    // 13! permutations cover the largest sweep size
+    string word = "abcdefghijklm";
+    vector<string> anagramKeys;
+    anagramKeys.reserve(2 * n);
+    for (size_t i = 0; i < 2 * n; i++) {
+        anagramKeys.push_back(word);
+        next_permutation(word.begin(), word.end());
+    }
+    shuffle(anagramKeys.begin(), anagramKeys.end(), rng);
+    profiles.push_back({"anagram",
+                        vector<string>(anagramKeys.begin(), anagramKeys.begin() + n),
+                        vector<string>(anagramKeys.begin() + n, anagramKeys.end()),
+                        makeUniformOrder(n, n, rng)});
+
+    return profiles;
+}
+
+// Adapters so one sweep can drive both HashTable and unordered_map.
+// Values are offset by 10000 so none hits HashTable's reserved 9999.
+using StdMap = unordered_map<string, size_t>;
+
+bool benchInsert(HashTable& t, const string& k, size_t v) { return t.insert(k, v + 10000); }
+bool benchInsert(StdMap& t, const string& k, size_t v) { return t.emplace(k, v + 10000).second; }
+size_t benchGet(const HashTable& t, const string& k) { return t.get(k).value_or(0); }
+size_t benchGet(const StdMap& t, const string& k) {
+    auto it = t.find(k);
+    return it == t.end() ? 0 : it->second;
+}
+bool benchContains(const HashTable& t, const string& k) { return t.contains(k); }
+bool benchContains(const StdMap& t, const string& k) { return t.contains(k); }
+size_t& benchUpdate(HashTable& t, const string& k) { return t[k]; }
+size_t& benchUpdate(StdMap& t, const string& k) { return t[k]; }
+bool benchRemove(HashTable& t, const string& k) { return t.remove(k); }
+bool benchRemove(StdMap& t, const string& k) { return t.erase(k) == 1; }
+size_t benchKeys(const HashTable& t) { return t.keys().size(); }
+size_t benchKeys(const StdMap& t) {
+    vector<string> result;
+    for (const auto& entry : t) {
+        result.push_back(entry.first);
+    }
+    return result.size();
+}
+
+//----------------------------------------------------------------
+// benchResize: Times one full rehash of a table holding at least
+//             every key. HashTable is filled with spare keys until
+//             the next insert doubles it, and that insert is timed.
+//             unordered_map is timed doubling its bucket count.
+//    Returns:  {elements moved, elapsed ns}
+//    Parameters:
+//       t (table) - table holding the profile's keys
+//       spare (vector<string>) - keys not in the table yet
+//---------------------------------------------------------------
+pair<size_t, double> benchResize(HashTable& t, const vector<string>& spare) {
+    size_t next = 0;
+    while (t.alpha() < 0.5 && next < spare.size()) {
+        t.insert(spare[next++], 0);
+    }
+    if (next >= spare.size()) {
+        return {0, 0.0};
+    }
+    size_t moved = t.size();
+    double ns = timeNs([&] { t.insert(spare[next], 0); });
+    return {moved, ns};
+}
+
+pair<size_t, double> benchResize(StdMap& t, const vector<string>&) {
+    size_t moved = t.size();
+    double ns = timeNs([&] { t.rehash(t.bucket_count() * 2); });
+    return {moved, ns};
+}
+
+//----------------------------------------------------------------
+// runOpsSweep: Runs every operation once on a fresh table for
+//             one profile and appends a row per operation.
+//    Returns:  void
+//    Parameters:
+//       tableName (string) - label for the table type
+//       profile (KeyProfile) - keys and lookup order
+//       rows (vector<BenchRow>&) - where results go
+//---------------------------------------------------------------
+template <typename Table>
+void runOpsSweep(const string& tableName, const KeyProfile& profile, vector<BenchRow>& rows) {
+    Table table;
+    const vector<string>& keys = profile.keys;
+    size_t n = keys.size();
+    size_t sum = 0;
+
+    auto record = [&](const string& op, size_t ops, double ns) {
+        rows.push_back({tableName, profile.name, op, n, ops, ns});
+    };
+
+    record("insert", n, timeNs([&] {
+        for (size_t i = 0; i < n; i++) {
+            sum += benchInsert(table, keys[i], i);
+        }
+    }));
+    record("get_hit", n, timeNs([&] {
+        for (size_t idx : profile.lookupOrder) {
+            sum += benchGet(table, keys[idx]);
+        }
+    }));
+    record("get_miss", n, timeNs([&] {
+        for (const auto& key : profile.missKeys) {
+            sum += benchGet(table, key);
+        }
+    }));
+    record("contains", n, timeNs([&] {
+        for (size_t idx : profile.lookupOrder) {
+            sum += benchContains(table, keys[idx]);
+        }
+    }));
+    record("update", n, timeNs([&] {
+        for (size_t idx : profile.lookupOrder) {
+            benchUpdate(table, keys[idx]) += 1;
+        }
+    }));
+    record("keys", n, timeNs([&] { sum += benchKeys(table); }));
+    record("remove", n, timeNs([&] {
+        for (size_t i = 0; i < n; i++) {
+            sum += benchRemove(table, keys[i]);
+        }
+    }));
+
+    // Refill and grow last so the spare keys do not disturb misses
+    Table grown;
+    for (size_t i = 0; i < n; i++) {
+        benchInsert(grown, keys[i], i);
+    }
+    auto [moved, ns] = benchResize(grown, profile.missKeys);
+    if (moved > 0) {
+        record("resize", moved, ns);
+    }
+
+    benchSink = benchSink + sum;
+}
+
+//----------------------------------------------------------------
+// printRows: Writes rows as CSV or as a JSON array. Each row has
+//             ns/op, ops/s and the peak RSS seen so far.
+//    Returns:  void
+//    Parameters:
+//       rows (vector<BenchRow>) - results to print
+//       json (bool) - JSON if true, CSV otherwise
+//       rssKb (vector<size_t>) - peak RSS recorded with each row
+//---------------------------------------------------------------
+void printRows(const vector<BenchRow>& rows, const vector<size_t>& rssKb, bool json) {
+    if (!json) {
+        cout << "table,profile,op,n,ops,ns_per_op,ops_per_sec,peak_rss_kb" << endl;
+    } else {
+        cout << "[" << endl;
+    }
+
+    for (size_t i = 0; i < rows.size(); i++) {
+        const BenchRow& row = rows[i];
+        double nsPerOp = row.totalNs / static_cast<double>(row.ops);
+        double opsPerSec = nsPerOp > 0.0 ? 1e9 / nsPerOp : 0.0;
+
+        if (json) {
+            cout << "  {\"table\": \"" << row.table << "\", \"profile\": \"" << row.profile
+                 << "\", \"op\": \"" << row.op << "\", \"n\": " << row.n
+                 << ", \"ops\": " << row.ops
+                 << ", \"ns_per_op\": " << fixed << setprecision(2) << nsPerOp
+                 << ", \"ops_per_sec\": " << setprecision(0) << opsPerSec
+                 << ", \"peak_rss_kb\": " << rssKb[i] << "}"
+                 << (i + 1 < rows.size() ? "," : "") << endl;
+        } else {
+            cout << row.table << "," << row.profile << "," << row.op << ","
+                 << row.n << "," << row.ops << ","
+                 << fixed << setprecision(2) << nsPerOp << ","
+                 << setprecision(0) << opsPerSec << ","
+                 << rssKb[i] << endl;
+        }
+    }
+
+    if (json) {
+        cout << "]" << endl;
+    }
+}
+
+//----------------------------------------------------------------
+// runOpsBenchmark: Sweeps table sizes 1K, 10K, ... up to maxSize
+//             over every profile for HashTable and unordered_map.
+//             Peak RSS is process-wide, so each row reports the
+//             high-water mark reached by the end of its sweep.
+//    Returns:  void
+//    Parameters:
+//       maxSize (size_t) - largest table size, at most 100M
+//       json (bool) - print JSON instead of CSV
+//---------------------------------------------------------------
+void runOpsBenchmark(size_t maxSize, bool json) {
+    vector<BenchRow> rows;
+    vector<size_t> rssKb;
+
+    for (size_t n = 1000; n <= maxSize; n *= 10) {
+        vector<KeyProfile> profiles = makeProfiles(n);
+        for (const auto& profile : profiles) {
+            runOpsSweep<HashTable>("HashTable", profile, rows);
+            rssKb.resize(rows.size(), peakRssKb());
+            runOpsSweep<StdMap>("unordered_map", profile, rows);
+            rssKb.resize(rows.size(), peakRssKb());
+        }
+    }
+
+    printRows(rows, rssKb, json);
+}
+
+//----------------------------------------------------------------
+// Concurrency sweep ("HashTableBench concurrent")
+//---------------------------------------------------------------
+
+// LockedHashTable is the baseline: one HashTable, one mutex
+class LockedHashTable {
+private:
+    mutable mutex lock;
+    HashTable table;
+
+public:
+    bool insert(string_view key, size_t value) {
+        lock_guard guard(lock);
+        return table.insert(key, value);
+    }
+    bool remove(string_view key) {
+        lock_guard guard(lock);
+        return table.remove(key);
+    }
+    optional<size_t> get(string_view key) const {
+        lock_guard guard(lock);
+        return table.get(key);
+    }
+};
+
+//----------------------------------------------------------------
+// runConcurrentMix: Runs opsPerThread operations on each of
+//             threadCount threads. Each op picks a random key;
+//             reads call get(), writes remove the key or insert it
+//             back, so the table size stays about the same.
+//    Returns:  total operations per second (double)
+//    Parameters:
+//       table (Table&) - table preloaded with keys
+//       keys (vector<string>) - key set
+//       threadCount (size_t) - worker threads
+//       readPercent (size_t) - share of ops that are reads
+//       opsPerThread (size_t) - operations per thread
+//---------------------------------------------------------------
+template <typename Table>
+double runConcurrentMix(Table& table, const vector<string>& keys, size_t threadCount,
+                        size_t readPercent, size_t opsPerThread) {
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (size_t t = 0; t < threadCount; t++) {
+        workers.emplace_back([&, t] {
+            mt19937_64 rng(t + 1);
+            size_t sum = 0;
+            for (size_t i = 0; i < opsPerThread; i++) {
+                uint64_t r = rng();
+                const string& key = keys[r % keys.size()];
+                if ((r >> 32) % 100 < readPercent) {
+                    sum += table.get(key).value_or(0);
+                } else if ((r >> 40) & 1) {
+                    sum += table.remove(key);
+                } else {
+                    sum += table.insert(key, 1);
+                }
+            }
+            benchSink = benchSink + sum;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto stop = chrono::steady_clock::now();
+    double seconds = chrono::duration<double>(stop - start).count();
+    return static_cast<double>(threadCount * opsPerThread) / seconds;
+}
+
+//----------------------------------------------------------------
+// runConcurrentBenchmark: Prints one CSV row per table, thread
+//             count (1, 2, 4, ... maxThreads) and read ratio.
+//    Returns:  void
+//    Parameters:
+//       maxThreads (size_t) - largest thread count
+//---------------------------------------------------------------
+void runConcurrentBenchmark(size_t maxThreads) {
+    constexpr size_t KEYS = 200000;
+    constexpr size_t OPS_PER_THREAD = 200000;
+    vector<string> keys = makeIdKeys(KEYS);
+
+    cout << "table,threads,read_percent,ops_per_sec" << endl;
+    for (size_t readPercent : {50, 90, 99, 100}) {
+        for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+            ConcurrentHashTable sharded(64);
+            OptimisticHashTable optimistic;
+            LockedHashTable locked;
+            for (const auto& key : keys) {
+                sharded.insert(key, 1);
+                optimistic.insert(key, 1);
+                locked.insert(key, 1);
+            }
+
+            double shardedOps = runConcurrentMix(sharded, keys, threads, readPercent, OPS_PER_THREAD);
+            double optimisticOps = runConcurrentMix(optimistic, keys, threads, readPercent, OPS_PER_THREAD);
+            double lockedOps = runConcurrentMix(locked, keys, threads, readPercent, OPS_PER_THREAD);
+            cout << "ConcurrentHashTable," << threads << "," << readPercent << ","
+                 << fixed << setprecision(0) << shardedOps << endl;
+            cout << "OptimisticHashTable," << threads << "," << readPercent << ","
+                 << optimisticOps << endl;
+            cout << "global_mutex," << threads << "," << readPercent << ","
+                 << lockedOps << endl;
+        }
+    }
+}
+
+//----------------------------------------------------------------
+// runBuildBenchmark: Builds a table of count keys (1% of them
+//             repeated) with a loop of insert() and with buildFrom()
+//             on 1, 2, 4, ... maxThreads threads, and prints CSV.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of pairs in the input
+//       maxThreads (size_t) - largest thread count
+//---------------------------------------------------------------
+void runBuildBenchmark(size_t count, size_t maxThreads) {
+    vector<string> keys = makeIdKeys(count);
+    for (size_t i = 0; i < count / 100; i++) {
+        keys[count - 1 - i] = keys[i];
+    }
+    vector<size_t> values(count);
+    iota(values.begin(), values.end(), size_t{10000});
+
+    cout << "method,threads,n,size,duplicates,ms" << endl;
+
+    auto start = chrono::steady_clock::now();
+    HashTable looped;
+    size_t rejected = 0;
+    for (size_t i = 0; i < count; i++) {
+        rejected += !looped.insert(keys[i], values[i]);
+    }
+    auto stop = chrono::steady_clock::now();
+    cout << "insert_loop,1," << count << "," << looped.size() << "," << rejected << ","
+         << fixed << setprecision(1) << chrono::duration<double, milli>(stop - start).count() << endl;
+
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        vector<size_t> duplicates;
+        start = chrono::steady_clock::now();
+        HashTable built = HashTable::buildFrom(span<const string>(keys), values, threads, &duplicates);
+        stop = chrono::steady_clock::now();
+        cout << "buildFrom," << threads << "," << count << "," << built.size() << ","
+             << duplicates.size() << ","
+             << chrono::duration<double, milli>(stop - start).count() << endl;
+    }
+}
+
+//----------------------------------------------------------------
+// runLoadFactorBenchmark: Inserts count keys for each growth
+//             policy and max load factor, with and without
+//             reserve(), and prints CSV: insert time, resizes,
+//             bytes per entry (bucket, value and control arrays
+//             plus the key arena) and average probes for hits and
+//             misses.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of keys to insert
+//---------------------------------------------------------------
+void runLoadFactorBenchmark(size_t count) {
+    vector<string> keys = makeIdKeys(count * 2);
+    vector<string> missing(keys.begin() + count, keys.end());
+    keys.resize(count);
+    size_t sample = min<size_t>(count, 100000);
+
+    const vector<pair<string, GrowthPolicy>> policies = {
+        {"2x", GrowthPolicy::DOUBLE},
+        {"1.5x", GrowthPolicy::ONE_AND_HALF},
+        {"prime", GrowthPolicy::PRIME}
+    };
+
+    cout << "growth,max_load_factor,reserved,n,capacity,resizes,insert_ms,"
+         << "bytes_per_entry,hit_probes,miss_probes" << endl;
+    for (const auto& [name, growth] : policies) {
+        for (double loadFactor : {0.5, 0.6, 0.7, 0.8, 0.9}) {
+            for (bool reserved : {false, true}) {
+                HashTable table;
+                table.setGrowthPolicy(growth);
+                table.setMaxLoadFactor(loadFactor);
+
+                size_t resizes = 0;
+                auto start = chrono::steady_clock::now();
+                if (reserved) {
+                    table.reserve(count);
+                }
+                for (size_t i = 0; i < count; i++) {
+                    size_t cap = table.capacity();
+                    table.insert(keys[i], i + 10000);
+                    resizes += table.capacity() != cap;
+                }
+                auto stop = chrono::steady_clock::now();
+
+                size_t hitProbes = 0;
+                size_t missProbes = 0;
+                for (size_t i = 0; i < sample; i++) {
+                    hitProbes += table.probeLength(keys[i]);
+                    missProbes += table.probeLength(missing[i]);
+                }
+                HashTableStats stats = table.stats();
+                double bytes = static_cast<double>(stats.bucketBytes + stats.controlBytes + stats.keyBytes);
+
+                cout << name << "," << loadFactor << "," << reserved << "," << count << ","
+                     << table.capacity() << "," << resizes << ","
+                     << fixed << setprecision(1) << chrono::duration<double, milli>(stop - start).count() << ","
+                     << bytes / count << ","
+                     << setprecision(3) << static_cast<double>(hitProbes) / sample << ","
+                     << static_cast<double>(missProbes) / sample << endl;
+                cout.unsetf(ios::fixed);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------
+// runSnapshotBenchmark: Saves a table of count keys and times
+//             getting it back three ways: inserting every key again,
+//             HashTable::openSnapshot(), and mapping it read-only
+//             with HashTableSnapshot (with and without checksum).
+//             Then times get() on the loaded table and the mapping.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of keys
+//       path (string) - snapshot file to write
+//---------------------------------------------------------------
+void runSnapshotBenchmark(size_t count, const string& path) {
+    vector<string> keys = makeIdKeys(count);
+    HashTable table;
+    for (size_t i = 0; i < count; i++) {
+        table.insert(keys[i], i + 10000);
+    }
+
+    auto timeMs = [](auto&& body) {
+        auto start = chrono::steady_clock::now();
+        body();
+        return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    };
+
+    bool saved = false;
+    double saveMs = timeMs([&] { saved = table.saveSnapshot(path); });
+    if (!saved) {
+        cout << "could not write " << path << endl;
+        return;
+    }
+
+    double reinsertMs = timeMs([&] {
+        HashTable rebuilt;
+        for (size_t i = 0; i < count; i++) {
+            rebuilt.insert(keys[i], i + 10000);
+        }
+    });
+    optional<HashTable> loaded;
+    double loadMs = timeMs([&] { loaded = HashTable::openSnapshot(path); });
+    optional<HashTableSnapshot> mapped;
+    double mapMs = timeMs([&] { mapped = HashTableSnapshot::open(path); });
+    optional<HashTableSnapshot> unchecked;
+    double mapUncheckedMs = timeMs([&] { unchecked = HashTableSnapshot::open(path, false); });
+    if (!loaded || !mapped || !unchecked) {
+        cout << "could not read " << path << endl;
+        return;
+    }
+
+    shuffle(keys.begin(), keys.end(), mt19937_64(3));
+    size_t sum = 0;
+    double loadedGetNs = timeMs([&] {
+        for (const auto& key : keys) {
+            sum += loaded->get(key).value_or(0);
+        }
+    }) * 1e6 / count;
+    double mappedGetNs = timeMs([&] {
+        for (const auto& key : keys) {
+            sum -= mapped->get(key).value_or(0);
+        }
+    }) * 1e6 / count;
+
+    cout << fixed << setprecision(1)
+         << "keys " << count << ", snapshot " << path << endl
+         << "save                         " << setw(10) << saveMs << " ms" << endl
+         << "insert every key again       " << setw(10) << reinsertMs << " ms" << endl
+         << "HashTable::openSnapshot      " << setw(10) << loadMs << " ms" << endl
+         << "HashTableSnapshot::open      " << setw(10) << mapMs << " ms" << endl
+         << "  without checksum           " << setw(10) << mapUncheckedMs << " ms" << endl
+         << "get, loaded table            " << setw(10) << loadedGetNs << " ns" << endl
+         << "get, mapped snapshot         " << setw(10) << mappedGetNs << " ns"
+         << (sum == 0 ? "" : "  (mismatch)") << endl;
+    remove(path.c_str());
+}
+
+//----------------------------------------------------------------
+// runFrozenBenchmark: Builds a FrozenHashTable from a HashTable of
+//             count keys and compares bytes per entry and get() time
+//             for hits and misses.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of keys
+//---------------------------------------------------------------
+void runFrozenBenchmark(size_t count) {
+    vector<string> keys = makeIdKeys(count * 2);
+    vector<string> missing(keys.begin() + count, keys.end());
+    keys.resize(count);
+
+    HashTable table;
+    for (size_t i = 0; i < count; i++) {
+        table.insert(keys[i], i + 10000);
+    }
+
+    auto start = chrono::steady_clock::now();
+    FrozenHashTable frozen(table);
+    double buildMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    shuffle(keys.begin(), keys.end(), mt19937_64(11));
+    auto timeGets = [](const auto& lookupTable, const vector<string>& lookupKeys) {
+        size_t found = 0;
+        auto begin = chrono::steady_clock::now();
+        for (const auto& key : lookupKeys) {
+            found += lookupTable.get(key).has_value();
+        }
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count() / lookupKeys.size();
+        return make_pair(ns, found);
+    };
+    auto [tableHitNs, tableHits] = timeGets(table, keys);
+    auto [tableMissNs, tableFalseHits] = timeGets(table, missing);
+    auto [frozenHitNs, frozenHits] = timeGets(frozen, keys);
+    auto [frozenMissNs, frozenFalseHits] = timeGets(frozen, missing);
+
+    HashTableStats stats = table.stats();
+    double tableBytes = static_cast<double>(stats.bucketBytes + stats.controlBytes + stats.keyBytes);
+
+    cout << left << setw(18) << "table" << right << setw(10) << "n" << setw(14) << "bytes/entry"
+         << setw(12) << "hit (ns)" << setw(12) << "miss (ns)" << setw(14) << "build (ms)" << endl;
+    cout << fixed << setprecision(1)
+         << left << setw(18) << "HashTable" << right << setw(10) << count << setw(14) << tableBytes / count
+         << setw(12) << tableHitNs << setw(12) << tableMissNs << setw(14) << "-" << endl;
+    cout << left << setw(18) << "FrozenHashTable" << right << setw(10) << frozen.size()
+         << setw(14) << static_cast<double>(frozen.memoryBytes()) / count
+         << setw(12) << frozenHitNs << setw(12) << frozenMissNs << setw(14) << buildMs << endl;
+    if (tableHits != count || frozenHits != count || tableFalseHits != 0 || frozenFalseHits != 0) {
+        cout << "(lookup mismatch)" << endl;
+    }
+}
+
+//----------------------------------------------------------------
+// runRobinHoodBenchmark: Fills a table of each probe policy to each
+//             load factor without resizing, then churns it: removes
+//             half the keys and inserts as many new ones. Prints
+//             CSV of insert, hit and miss times, average and longest
+//             probes, before and after the churn.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of keys in the table
+//---------------------------------------------------------------
+void runRobinHoodBenchmark(size_t count) {
+    vector<string> keys = makeIdKeys(count * 3);
+    vector<string> missing(keys.begin() + count * 2, keys.end());
+    vector<string> replacements(keys.begin() + count, keys.begin() + count * 2);
+    keys.resize(count);
+    size_t sample = min<size_t>(count, 200000);
+
+    const vector<pair<string, ProbePolicy>> policies = {
+        {"double_hash", ProbePolicy::DOUBLE_HASH},
+        {"robin_hood", ProbePolicy::ROBIN_HOOD}
+    };
+
+    auto timeGets = [sample](const HashTable& table, const vector<string>& lookupKeys) {
+        size_t found = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < sample; i++) {
+            found += table.get(lookupKeys[i]).has_value();
+        }
+        benchSink = benchSink + found;
+        return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / sample;
+    };
+    auto averageProbes = [sample](const HashTable& table, const vector<string>& lookupKeys) {
+        size_t probes = 0;
+        for (size_t i = 0; i < sample; i++) {
+            probes += table.probeLength(lookupKeys[i]);
+        }
+        return static_cast<double>(probes) / sample;
+    };
+
+    cout << "policy,load_factor,phase,n,capacity,insert_ns,hit_ns,miss_ns,"
+         << "hit_probes,miss_probes,longest_probe,tombstones" << endl;
+    for (double loadFactor : {0.5, 0.6, 0.7, 0.8, 0.9}) {
+        for (const auto& [name, probing] : policies) {
+            // Sized up front and allowed to fill past loadFactor, so
+            // neither phase resizes
+            HashTable table(static_cast<size_t>(count / loadFactor) + 1);
+            table.setProbePolicy(probing);
+            table.setMaxLoadFactor(0.95);
+
+            vector<string> present = keys;
+            mt19937_64 rng(17);
+            double insertNs = 0;
+            for (string phase : {"fresh", "churned"}) {
+                auto start = chrono::steady_clock::now();
+                if (phase == "fresh") {
+                    for (size_t i = 0; i < count; i++) {
+                        table.insert(keys[i], i + 10000);
+                    }
+                } else {
+                    // Remove half the keys at random, then insert new ones
+                    shuffle(present.begin(), present.end(), rng);
+                    for (size_t i = 0; i < count / 2; i++) {
+                        table.remove(present[i]);
+                        table.insert(replacements[i], i + 10000);
+                        present[i] = replacements[i];
+                    }
+                }
+                size_t operations = phase == "fresh" ? count : count / 2;
+                insertNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / operations;
+
+                shuffle(present.begin(), present.end(), rng);
+                double hitNs = timeGets(table, present);
+                double missNs = timeGets(table, missing);
+                HashTableStats stats = table.stats();
+
+                cout << name << "," << loadFactor << "," << phase << "," << table.size() << ","
+                     << table.capacity() << "," << fixed << setprecision(1) << insertNs << ","
+                     << hitNs << "," << missNs << "," << setprecision(3)
+                     << averageProbes(table, present) << "," << averageProbes(table, missing) << ","
+                     << stats.longestProbe << "," << stats.tombstones << endl;
+                cout.unsetf(ios::fixed);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------
+// runEngineLatency: Inserts count keys into a fresh Table, then
+//             times every lookup of a shuffled sample of hits and
+//             misses on its own, and prints one row: mean insert
+//             time, mean, p99, p99.9 and max lookup time, and the
+//             final load factor. Each lookup timing includes about
+//             20 ns of clock overhead, the same for every table.
+//    Returns:  void
+//    Parameters:
+//       name (string) - label for the row
+//       table (Table&) - empty table to fill
+//       keys (vector<string>) - keys to insert
+//       missing (vector<string>) - keys never inserted
+//---------------------------------------------------------------
+template <typename Table>
+void runEngineLatency(const string& name, Table& table, const vector<string>& keys, const vector<string>& missing) {
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); i++) {
+        table.insert(keys[i], i + 10000);
+    }
+    double insertNs = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / keys.size();
+
+    size_t sample = min<size_t>(keys.size(), 200000);
+    vector<string> lookups(keys.begin(), keys.begin() + sample);
+    lookups.insert(lookups.end(), missing.begin(), missing.begin() + sample);
+    shuffle(lookups.begin(), lookups.end(), mt19937_64(23));
+
+    vector<double> latencies;
+    latencies.reserve(lookups.size());
+    size_t found = 0;
+    for (const auto& key : lookups) {
+        auto begin = chrono::steady_clock::now();
+        found += table.get(key).has_value();
+        latencies.push_back(chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count());
+    }
+    benchSink = benchSink + found;
+
+    double mean = accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) {
+        return latencies[min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+
+    cout << fixed << setprecision(1) << left << setw(22) << name << right << setw(10) << keys.size()
+         << setw(12) << insertNs << setw(10) << mean << setw(10) << percentile(0.99)
+         << setw(10) << percentile(0.999) << setw(12) << latencies.back()
+         << setw(8) << setprecision(3) << table.alpha() << endl;
+    cout.unsetf(ios::fixed);
+    if (found != sample) {
+        cout << "(lookup mismatch)" << endl;
+    }
+}
+
+//----------------------------------------------------------------
+// runCuckooBenchmark: Compares CuckooHashTable with HashTable under
+//             both probe policies, all filled to the same load
+//             factor ceiling of 0.9.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of keys to insert
+//---------------------------------------------------------------
+void runCuckooBenchmark(size_t count) {
+    vector<string> keys = makeIdKeys(count * 2);
+    vector<string> missing(keys.begin() + count, keys.end());
+    keys.resize(count);
+
+    cout << left << setw(22) << "table" << right << setw(10) << "n" << setw(12) << "insert ns"
+         << setw(10) << "get ns" << setw(10) << "p99" << setw(10) << "p99.9" << setw(12) << "max"
+         << setw(8) << "alpha" << endl;
+
+    HashTable doubleHash;
+    doubleHash.setMaxLoadFactor(0.9);
+    runEngineLatency("HashTable double", doubleHash, keys, missing);
+
+    HashTable robinHood;
+    robinHood.setProbePolicy(ProbePolicy::ROBIN_HOOD);
+    robinHood.setMaxLoadFactor(0.9);
+    runEngineLatency("HashTable robin", robinHood, keys, missing);
+
+    CuckooHashTable cuckoo;
+    runEngineLatency("CuckooHashTable", cuckoo, keys, missing);
+}
+
+//----------------------------------------------------------------
+// runScanBenchmark: Reads every pair of a table of count keys with
+//             keys() plus get(), with range-for and with forEach(),
+//             and prints time and allocations for each. Every way
+//             must see the same sum of values.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of keys in the table
+//---------------------------------------------------------------
+void runScanBenchmark(size_t count) {
+    vector<string> keys = makeIdKeys(count);
+    HashTable table;
+    for (size_t i = 0; i < count; i++) {
+        table.insert(keys[i], i + 10000);
+    }
+
+    auto timeScan = [](const string& name, auto&& scan) {
+        size_t allocsBefore = allocationCount;
+        auto start = chrono::steady_clock::now();
+        size_t sum = scan();
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        size_t allocs = allocationCount - allocsBefore;
+        benchSink = benchSink + sum;
+        cout << left << setw(18) << name << right << setw(12) << fixed << setprecision(1) << ms
+             << setw(14) << allocs << setw(20) << sum << endl;
+        cout.unsetf(ios::fixed);
+    };
+
+    cout << left << setw(18) << "scan" << right << setw(12) << "time (ms)" << setw(14) << "allocations"
+         << setw(20) << "sum" << endl;
+    timeScan("keys() + get()", [&table] {
+        size_t sum = 0;
+        for (const string& key : table.keys()) {
+            sum += *table.get(key);
+        }
+        return sum;
+    });
+    timeScan("range-for", [&table] {
+        size_t sum = 0;
+        for (auto [key, value] : table) {
+            sum += value;
+        }
+        return sum;
+    });
+    timeScan("forEach", [&table] {
+        size_t sum = 0;
+        table.forEach([&sum](std::string_view, size_t value) {
+            sum += value;
+        });
+        return sum;
+    });
+}
+
+//----------------------------------------------------------------
+// runCounterBenchmark: Counts events drawn from a Zipf distribution
+//             over distinct keys, the word-count pattern. The
+//             two-probe way checks contains() and then calls
+//             insert() or operator[]; fetchAdd() does one probe.
+//             Both must end with the same counts.
+//    Returns:  void
+//    Parameters:
+//       events (size_t) - number of updates
+//       distinct (size_t) - number of different keys
+//---------------------------------------------------------------
+void runCounterBenchmark(size_t events, size_t distinct) {
+    vector<string> words = makeIdKeys(distinct);
+    mt19937_64 rng(29);
+    vector<size_t> stream = makeZipfOrder(distinct, events, 0.99, rng);
+
+    auto timeCount = [&](const string& name, auto&& countEvent) {
+        HashTable table;
+        auto start = chrono::steady_clock::now();
+        for (size_t wordIdx : stream) {
+            countEvent(table, words[wordIdx]);
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        size_t total = 0;
+        for (auto [word, count] : table) {
+            total += count;
+        }
+        cout << left << setw(22) << name << right << setw(12) << events << setw(12) << table.size()
+             << setw(12) << fixed << setprecision(1) << ms << setw(12) << ms * 1e6 / events
+             << (total == events ? "" : "  (count mismatch)") << endl;
+        cout.unsetf(ios::fixed);
+    };
+
+    cout << left << setw(22) << "update" << right << setw(12) << "events" << setw(12) << "distinct"
+         << setw(12) << "time (ms)" << setw(12) << "ns/event" << endl;
+    timeCount("contains + insert/[]", [](HashTable& table, const string& word) {
+        if (table.contains(word)) {
+            table[word]++;
+        } else {
+            table.insert(word, 1);
+        }
+    });
+    timeCount("fetchAdd", [](HashTable& table, const string& word) {
+        table.fetchAdd(word, 1);
+    });
+}
+
+//----------------------------------------------------------------
+// runMemoryBenchmark: Fills a table with short numeric keys and
+//             with 21-byte ID keys and prints memoryUsage() per
+//             entry for each array. Keys are made one at a time,
+//             so only the table itself has to fit in memory.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - number of keys
+//---------------------------------------------------------------
+void runMemoryBenchmark(size_t count) {
+    auto measure = [count](const string& name, auto&& makeKey) {
+        HashTable table;
+        for (size_t i = 0; i < count; i++) {
+            table.insert(makeKey(i), i + 10000);
+        }
+        HashTableMemory memory = table.memoryUsage();
+        double n = static_cast<double>(count);
+        cout << left << setw(10) << name << right << setw(12) << count << setw(12) << table.capacity()
+             << fixed << setprecision(1)
+             << setw(10) << memory.controlBytes / n << setw(10) << memory.bucketBytes / n
+             << setw(10) << memory.valueBytes / n << setw(10) << memory.keyBytes / n
+             << setw(12) << memory.bytesPerEntry()
+             << (table.size() == count ? "" : "  (size mismatch)") << endl;
+        cout.unsetf(ios::fixed);
+    };
+
+    cout << left << setw(10) << "keys" << right << setw(12) << "n" << setw(12) << "capacity"
+         << setw(10) << "control" << setw(10) << "buckets" << setw(10) << "values"
+         << setw(10) << "arena" << setw(12) << "bytes/entry" << endl;
+    measure("numeric", [](size_t i) {
+        return to_string(i + 1);
+    });
+    measure("id", [](size_t i) {
+        string digits = to_string(i);
+        return "order-2024-" + string(10 - min<size_t>(10, digits.size()), '0') + digits;
+    });
+}
+
+//----------------------------------------------------------------
+// runAllocatorBenchmark: Compares the memory resource a table
+//             allocates from. First serves requests that each build
+//             a 64-key table, look every key up and drop it, on the
+//             global heap and on a monotonic_buffer_resource over a
+//             stack buffer. Then fills one table of count ID keys
+//             without reserve() on the global heap, a monotonic
+//             arena (which never frees the arrays growth replaces)
+//             and a HugePageResource, and times inserts, lookups in
+//             random order and destruction. Calls to the global
+//             operator new are counted for each.
+//    Returns:  void
+//    Parameters:
+//       count (size_t) - keys in the large table
+//       requests (size_t) - number of short-lived tables
+//---------------------------------------------------------------
+void runAllocatorBenchmark(size_t count, size_t requests) {
+    vector<string> small = makeIdKeys(64);
+    size_t found = 0;
+    auto serve = [&](HashTable& table) {
+        for (size_t i = 0; i < small.size(); i++) {
+            table.insert(small[i], i + 10000);
+        }
+        for (const string& key : small) {
+            found += table.contains(key);
+        }
+    };
+    auto runRequests = [&](const string& name, auto&& request) {
+        size_t allocsBefore = allocationCount;
+        double ns = timeNs([&] {
+            for (size_t r = 0; r < requests; r++) {
+                request();
+            }
+        });
+        cout << left << setw(22) << name << right << setw(10) << requests
+             << setw(16) << fixed << setprecision(1) << ns / requests
+             << setw(16) << static_cast<double>(allocationCount - allocsBefore) / requests << endl;
+        cout.unsetf(ios::fixed);
+    };
+
+    cout << left << setw(22) << "64-key tables" << right << setw(10) << "requests"
+         << setw(16) << "ns/request" << setw(16) << "allocs/request" << endl;
+    runRequests("heap", [&] {
+        HashTable table;
+        serve(table);
+    });
+    runRequests("monotonic (stack)", [&] {
+        alignas(max_align_t) char buffer[64 * 1024];
+        pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+        HashTable table(HashTable::DEFAULT_INITIAL_CAPACITY, HashPolicy::MIX64, ResizeMode::STOP_THE_WORLD, 0, &arena);
+        serve(table);
+    });
+    if (found != requests * small.size() * 2) {
+        cout << "lookup mismatch" << endl;
+    }
+
+    vector<string> keys = makeIdKeys(count);
+    vector<size_t> order(count);
+    iota(order.begin(), order.end(), size_t{0});
+    shuffle(order.begin(), order.end(), mt19937_64(7));
+    auto runLarge = [&](const string& name, pmr::memory_resource* memory) {
+        size_t allocsBefore = allocationCount;
+        auto table = make_unique<HashTable>(HashTable::DEFAULT_INITIAL_CAPACITY, HashPolicy::MIX64,
+                                            ResizeMode::STOP_THE_WORLD, 0, memory);
+        double insertNs = timeNs([&] {
+            for (size_t i = 0; i < count; i++) {
+                table->insert(keys[i], i + 10000);
+            }
+        });
+        size_t sum = 0;
+        double getNs = timeNs([&] {
+            for (size_t i : order) {
+                sum += table->get(keys[i]).value_or(0);
+            }
+        });
+        benchSink = benchSink + sum;
+        double freeNs = timeNs([&] {
+            table.reset();
+        });
+        cout << left << setw(22) << name << right << setw(10) << count << fixed << setprecision(1)
+             << setw(16) << insertNs / count << setw(16) << getNs / count
+             << setw(12) << freeNs / 1e6 << setw(10) << allocationCount - allocsBefore << endl;
+        cout.unsetf(ios::fixed);
+    };
+
+    cout << endl << left << setw(22) << "large table" << right << setw(10) << "n"
+         << setw(16) << "insert (ns)" << setw(16) << "get (ns)"
+         << setw(12) << "free (ms)" << setw(10) << "allocs" << endl;
+    runLarge("heap", pmr::new_delete_resource());
+    {
+        pmr::monotonic_buffer_resource arena;
+        runLarge("monotonic", &arena);
+    }
+    HugePageResource pages;
+    runLarge("huge pages", &pages);
+    cout << (pages.usesReservedPages() ? "huge pages: reserved (MAP_HUGETLB)"
+                                       : "huge pages: transparent (no MAP_HUGETLB pages reserved)") << endl;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "alloc") {
+        runAllocatorBenchmark(argc > 2 ? stoul(argv[2]) : 1000000, argc > 3 ? stoul(argv[3]) : 100000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "memory") {
+        runMemoryBenchmark(argc > 2 ? stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "counter") {
+        runCounterBenchmark(argc > 2 ? stoul(argv[2]) : 10000000, argc > 3 ? stoul(argv[3]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "scan") {
+        runScanBenchmark(argc > 2 ? stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "cuckoo") {
+        runCuckooBenchmark(argc > 2 ? stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "robin") {
+        runRobinHoodBenchmark(argc > 2 ? stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "frozen") {
+        runFrozenBenchmark(argc > 2 ? stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "snapshot") {
+        runSnapshotBenchmark(argc > 2 ? stoul(argv[2]) : 1000000,
+                             argc > 3 ? argv[3] : "HashTableBench.snapshot");
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "load") {
+        runLoadFactorBenchmark(argc > 2 ? stoul(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "build") {
+        size_t count = argc > 2 ? stoul(argv[2]) : 5000000;
+        runBuildBenchmark(count, argc > 3 ? stoul(argv[3]) : thread::hardware_concurrency());
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "ops") {
+        size_t maxSize = argc > 2 ? stoul(argv[2]) : 1000000;
+        bool json = argc > 3 && string(argv[3]) == "json";
+        runOpsBenchmark(min<size_t>(maxSize, 100000000), json);
+        return 0;
+    }
+    if (argc > 1 && string(argv[1]) == "concurrent") {
+        runConcurrentBenchmark(argc > 2 ? stoul(argv[2]) : 64);
+        return 0;
+    }
+
+    size_t count = 20000;
+    if (argc > 1) {
+        count = stoul(argv[1]);
+    }
+    size_t growthCount = 1000000;
+    if (argc > 2) {
+        growthCount = stoul(argv[2]);
+    }
+
+    cout << left << setw(10) << "keys" << setw(12) << "policy"
+         << right << setw(10) << "n" << setw(12) << "avg probe"
+         << setw(10) << "max probe" << setw(14) << "insert (ms)" << endl;
+
+    vector<pair<string, vector<string>>> keySets = {
+        {"id", makeIdKeys(count)},
+        {"numeric", makeNumericKeys(count)},
+        {"anagram", makeAnagramKeys(count)}
+    };
+
+    for (const auto& [name, keys] : keySets) {
+        runProbeBenchmark(name, keys, HashPolicy::MIX64);
+        runProbeBenchmark(name, keys, HashPolicy::LEGACY_SUM);
+    }
+
+    cout << endl << left << setw(16) << "resize mode"
+         << right << setw(10) << "n" << setw(14) << "total (ms)"
+         << setw(12) << "p99 (us)" << setw(14) << "worst (us)" << endl;
+
+    vector<string> latencyKeys = makeIdKeys(count * 50);
+    runResizeLatencyBenchmark(latencyKeys, ResizeMode::STOP_THE_WORLD);
+    runResizeLatencyBenchmark(latencyKeys, ResizeMode::INCREMENTAL);
+    latencyKeys.clear();
+    latencyKeys.shrink_to_fit();
+
+    cout << endl << right << setw(10) << "n" << setw(12) << "capacity"
+         << setw(10) << "resizes" << setw(14) << "table allocs"
+         << setw(14) << "total (ms)" << endl;
+
+    runGrowthBenchmark(makeIdKeys(growthCount));
+
+    cout << endl << left << setw(22) << "table" << right << setw(10) << "n"
+         << setw(14) << "total (ms)" << setw(14) << "bytes/entry" << endl;
+
+    runIntegerKeyBenchmark(growthCount);
+
+    cout << endl << right << setw(10) << "n" << setw(14) << "get (ns)"
+         << setw(14) << "getBatch (ns)" << endl;
+
+    runBatchBenchmark(growthCount);
+
+    return 0;
+}
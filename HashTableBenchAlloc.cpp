@@ -0,0 +1,46 @@
+/**
+ * HashTableBenchAlloc.cpp
+ * Counting replacements for the global operator new and delete
+ */
+#include "HashTableBenchAlloc.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+size_t allocationCount = 0;
+
+void* operator new(size_t size) {
+    allocationCount++;
+    if (void* p = malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+// std::pmr::new_delete_resource() allocates through the aligned form
+void* operator new(size_t size, align_val_t alignment) {
+    allocationCount++;
+    size_t align = static_cast<size_t>(alignment);
+    if (void* p = aligned_alloc(align, (max<size_t>(size, 1) + align - 1) / align * align)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* p, align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t, align_val_t) noexcept {
+    free(p);
+}
@@ -0,0 +1,18 @@
+/**
+ * HashTableBenchAlloc.h
+ *
+ * Allocation counter for HashTableBench. HashTableBenchAlloc.cpp
+ * replaces the global operator new and delete so the benchmarks can
+ * report how many allocations a table makes. The replacements live in
+ * their own translation unit so the compiler never inlines malloc()
+ * into a new expression and then warns that delete calls free().
+ */
+#ifndef HASHTABLEBENCHALLOC_H
+#define HASHTABLEBENCHALLOC_H
+
+#include <cstddef>
+
+// Calls to any form of the global operator new so far
+extern size_t allocationCount;
+
+#endif
@@ -0,0 +1,478 @@
+/**
+ * HashTableSnapshot.cpp
+ * Binary snapshots of a HashTable: HashTable::saveSnapshot(),
+ * HashTable::openSnapshot() and the memory-mapped read-only view
+ */
+#include "HashTableSnapshot.h"
+#include <cstring>
+#include <fstream>
+#include <utility>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+//----------------------------------------------------------------
+// alignUp: Rounds n up to a multiple of 8.
+//    Returns:  rounded value (size_t)
+//---------------------------------------------------------------
+size_t alignUp(size_t n) {
+    return (n + 7) & ~size_t{7};
+}
+
+//----------------------------------------------------------------
+// hashBytes: MIX64 hash of a byte range, for checksums.
+//    Returns:  hash (uint64_t)
+//---------------------------------------------------------------
+uint64_t hashBytes(const void* data, size_t bytes) {
+    return hashMix64(std::string_view(static_cast<const char*>(data), bytes));
+}
+
+}
+
+//----------------------------------------------------------------
+// layoutFor: Computes where each section starts.
+//    Returns:  section offsets and total file size (Layout)
+//    Parameters:
+//       capacity (uint64_t) - number of buckets
+//       arenaBytes (uint64_t) - total key bytes
+//---------------------------------------------------------------
+HashTableSnapshot::Layout HashTableSnapshot::layoutFor(uint64_t capacity, uint64_t arenaBytes) {
+    Layout layout;
+    layout.control = sizeof(SnapshotHeader);
+    layout.hashes = alignUp(layout.control + capacity);
+    layout.keyEnds = layout.hashes + capacity * sizeof(uint64_t);
+    layout.values = layout.keyEnds + capacity * sizeof(uint64_t);
+    layout.arena = layout.values + capacity * sizeof(uint64_t);
+    layout.total = layout.arena + arenaBytes;
+    return layout;
+}
+
+//----------------------------------------------------------------
+// checksumOf: Checksums a snapshot: the header with its checksum
+//             field cleared, then each section, folded together.
+//    Returns:  checksum (uint64_t)
+//    Parameters:
+//       header (const SnapshotHeader&) - header to include
+//       base (const char*) - start of the file image
+//       layout (const Layout&) - section offsets
+//---------------------------------------------------------------
+uint64_t HashTableSnapshot::checksumOf(const SnapshotHeader& header, const char* base, const Layout& layout) {
+    SnapshotHeader cleared = header;
+    cleared.checksum = 0;
+
+    uint64_t parts[] = {
+        hashBytes(&cleared, sizeof(cleared)),
+        hashBytes(base + layout.control, layout.hashes - layout.control),
+        hashBytes(base + layout.hashes, layout.keyEnds - layout.hashes),
+        hashBytes(base + layout.keyEnds, layout.values - layout.keyEnds),
+        hashBytes(base + layout.values, layout.arena - layout.values),
+        hashBytes(base + layout.arena, layout.total - layout.arena)
+    };
+    return hashBytes(parts, sizeof(parts));
+}
+
+//----------------------------------------------------------------
+// saveSnapshot: Writes the table to path in the binary snapshot
+//             format (see HashTableSnapshot.h). Buckets keep their
+//             indexes and EAR buckets are kept as EAR. Elements
+//             still in the old array of an incremental resize are
+//             placed into the written layout as if migrated, in
+//             probe distance order for Robin Hood tables.
+//    Returns:  true if the whole file was written (bool)
+//    Parameters:
+//       path (string) - file to create or replace
+//---------------------------------------------------------------
+bool HashTable::saveSnapshot(const std::string& path) const {
+    size_t cap = tableData.size();
+    std::vector<uint8_t> ctrl(control.begin(), control.end());
+    // Bucket and value for each written slot, nullptr if empty
+    std::vector<std::pair<const HashTableBucket*, size_t>> slots(cap, {nullptr, 0});
+    for (size_t i = 0; i < cap; i++) {
+        if (ctrl[i] < CTRL_EMPTY) {
+            slots[i] = {&tableData[i], valueData[i]};
+        }
+    }
+    for (size_t i = 0; i < oldData.size(); i++) {
+        if (oldControl[i] >= CTRL_EMPTY) {
+            continue;
+        }
+        uint64_t hash = oldData[i].hash;
+        size_t bucketIdx = homeBucket(hash, cap);
+        size_t step = 0;
+        if (probing == ProbePolicy::ROBIN_HOOD) {
+            // Stop at the first richer key, then shift the run forward
+            for (size_t distance = 0; ctrl[bucketIdx] < CTRL_EMPTY &&
+                 probeDistance(slots[bucketIdx].first->hash, bucketIdx, cap) >= distance; distance++) {
+                bucketIdx = nextProbe(bucketIdx, hash, cap, step);
+            }
+            size_t end = bucketIdx;
+            while (ctrl[end] < CTRL_EMPTY) {
+                end = end + 1 == cap ? 0 : end + 1;
+            }
+            while (end != bucketIdx) {
+                size_t prev = end == 0 ? cap - 1 : end - 1;
+                ctrl[end] = ctrl[prev];
+                slots[end] = slots[prev];
+                end = prev;
+            }
+        } else {
+            while (ctrl[bucketIdx] < CTRL_EMPTY) {
+                bucketIdx = nextProbe(bucketIdx, hash, cap, step);
+            }
+        }
+        ctrl[bucketIdx] = controlTag(hash);
+        slots[bucketIdx] = {&oldData[i], oldValues[i]};
+    }
+
+    std::vector<uint64_t> hashes(cap, 0);
+    std::vector<uint64_t> keyEnds(cap, 0);
+    std::vector<uint64_t> values(cap, 0);
+    std::string arena;
+    for (size_t i = 0; i < cap; i++) {
+        if (slots[i].first != nullptr) {
+            hashes[i] = slots[i].first->hash;
+            values[i] = slots[i].second;
+            arena.append(keyOf(*slots[i].first));
+        }
+        keyEnds[i] = arena.size();
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SnapshotHeader::MAGIC, sizeof(header.magic));
+    header.version = SnapshotHeader::VERSION;
+    header.byteOrder = SnapshotHeader::BYTE_ORDER_MARK;
+    header.capacity = cap;
+    header.size = numElements;
+    header.probeSeed = probeSeed;
+    header.hashPolicy = static_cast<uint32_t>(policy);
+    header.probePolicy = static_cast<uint32_t>(probing);
+    header.arenaBytes = arena.size();
+
+    // Assemble the image so the checksum covers exactly what is written
+    HashTableSnapshot::Layout layout = HashTableSnapshot::layoutFor(cap, arena.size());
+    std::string image(layout.total, '\0');
+    std::memcpy(image.data() + layout.control, ctrl.data(), cap);
+    std::memcpy(image.data() + layout.hashes, hashes.data(), cap * sizeof(uint64_t));
+    std::memcpy(image.data() + layout.keyEnds, keyEnds.data(), cap * sizeof(uint64_t));
+    std::memcpy(image.data() + layout.values, values.data(), cap * sizeof(uint64_t));
+    std::memcpy(image.data() + layout.arena, arena.data(), arena.size());
+    header.checksum = HashTableSnapshot::checksumOf(header, image.data(), layout);
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(image.data(), static_cast<std::streamsize>(image.size()));
+    out.close();
+    return !out.fail();
+}
+
+//----------------------------------------------------------------
+// openSnapshot: Loads a snapshot into a new, writable HashTable.
+//             The bucket layout is copied as saved, so no key is
+//             hashed, probed or checked for duplicates; the only
+//             work per key is copying it out of the file.
+//    Returns:  the table, or std::nullopt if the file is missing,
+//             unreadable or corrupt
+//    Parameters:
+//       path (string) - snapshot file
+//---------------------------------------------------------------
+std::optional<HashTable> HashTable::openSnapshot(const std::string& path) {
+    std::optional<HashTableSnapshot> snapshot = HashTableSnapshot::open(path);
+    if (!snapshot) {
+        return std::nullopt;
+    }
+
+    size_t cap = snapshot->capacity();
+    HashTable table(cap, static_cast<HashPolicy>(snapshot->header->hashPolicy),
+                    ResizeMode::STOP_THE_WORLD, snapshot->header->probeSeed);
+    table.probing = static_cast<ProbePolicy>(snapshot->header->probePolicy);
+    std::memcpy(table.control.data(), snapshot->control, cap);
+    for (size_t i = 0; i < cap; i++) {
+        if (table.control[i] < CTRL_EMPTY) {
+            table.tableData[i] = storeKey(table.keyArena, snapshot->keyAt(i), snapshot->hashes[i]);
+            table.valueData[i] = snapshot->values[i];
+            table.numElements++;
+        } else if (table.control[i] == CTRL_DELETED) {
+            table.numRemoved++;
+        }
+    }
+    return table;
+}
+
+//----------------------------------------------------------------
+// mapFile: Maps path read-only, or reads it into memory where
+//             mmap is not available.
+//    Returns:  true if the file is now in memory (bool)
+//    Parameters:
+//       path (string) - file to map
+//---------------------------------------------------------------
+bool HashTableSnapshot::mapFile(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    mappedBytes = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, mappedBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    base = static_cast<const char*>(mapping);
+    isMapped = true;
+    return true;
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        return false;
+    }
+    mappedBytes = static_cast<size_t>(in.tellg());
+    buffer = std::make_unique<uint64_t[]>((mappedBytes + 7) / 8);
+    in.seekg(0);
+    in.read(reinterpret_cast<char*>(buffer.get()), static_cast<std::streamsize>(mappedBytes));
+    base = reinterpret_cast<const char*>(buffer.get());
+    return static_cast<bool>(in);
+#endif
+}
+
+//----------------------------------------------------------------
+// validateHeader: Checks the header against this build and the
+//             file size, before any section is read.
+//    Returns:  true if the sections lie inside the file (bool)
+//---------------------------------------------------------------
+bool HashTableSnapshot::validateHeader() const {
+    if (std::memcmp(header->magic, SnapshotHeader::MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SnapshotHeader::VERSION ||
+        header->byteOrder != SnapshotHeader::BYTE_ORDER_MARK ||
+        header->hashPolicy > static_cast<uint32_t>(HashPolicy::LEGACY_SUM) ||
+        header->probePolicy > static_cast<uint32_t>(ProbePolicy::ROBIN_HOOD) ||
+        header->capacity == 0 || header->capacity > mappedBytes ||
+        header->arenaBytes > mappedBytes || header->size > header->capacity) {
+        return false;
+    }
+    return layoutFor(header->capacity, header->arenaBytes).total == mappedBytes;
+}
+
+//----------------------------------------------------------------
+// verifyContents: Checks the checksum and that key offsets never
+//             go backwards or past the arena. Reads the whole file.
+//    Returns:  true if the snapshot is intact (bool)
+//---------------------------------------------------------------
+bool HashTableSnapshot::verifyContents() const {
+    if (checksumOf(*header, base, layoutFor(header->capacity, header->arenaBytes)) != header->checksum) {
+        return false;
+    }
+    uint64_t previous = 0;
+    for (size_t i = 0; i < header->capacity; i++) {
+        if (keyEnds[i] < previous) {
+            return false;
+        }
+        previous = keyEnds[i];
+    }
+    return previous <= header->arenaBytes;
+}
+
+//----------------------------------------------------------------
+// open: Maps and validates a snapshot file.
+//    Returns:  the snapshot, or std::nullopt if it cannot be used
+//    Parameters:
+//       path (string) - snapshot file
+//       verifyChecksum (bool) - check the checksum before returning
+//---------------------------------------------------------------
+std::optional<HashTableSnapshot> HashTableSnapshot::open(const std::string& path, bool verifyChecksum) {
+    HashTableSnapshot snapshot;
+    if (!snapshot.mapFile(path) || snapshot.mappedBytes < sizeof(SnapshotHeader)) {
+        return std::nullopt;
+    }
+
+    snapshot.header = reinterpret_cast<const SnapshotHeader*>(snapshot.base);
+    if (!snapshot.validateHeader()) {
+        return std::nullopt;
+    }
+
+    Layout layout = layoutFor(snapshot.header->capacity, snapshot.header->arenaBytes);
+    snapshot.control = reinterpret_cast<const uint8_t*>(snapshot.base + layout.control);
+    snapshot.hashes = reinterpret_cast<const uint64_t*>(snapshot.base + layout.hashes);
+    snapshot.keyEnds = reinterpret_cast<const uint64_t*>(snapshot.base + layout.keyEnds);
+    snapshot.values = reinterpret_cast<const uint64_t*>(snapshot.base + layout.values);
+    snapshot.arena = snapshot.base + layout.arena;
+
+    if (verifyChecksum && !snapshot.verifyContents()) {
+        return std::nullopt;
+    }
+    return snapshot;
+}
+
+//----------------------------------------------------------------
+// HashTableSnapshot (move constructor): Takes over the mapping.
+//---------------------------------------------------------------
+HashTableSnapshot::HashTableSnapshot(HashTableSnapshot&& other) noexcept {
+    *this = std::move(other);
+}
+
+//----------------------------------------------------------------
+// operator=: Releases this mapping and takes over other's.
+//    Returns:  this snapshot (HashTableSnapshot&)
+//---------------------------------------------------------------
+HashTableSnapshot& HashTableSnapshot::operator=(HashTableSnapshot&& other) noexcept {
+    if (this != &other) {
+        release();
+        base = std::exchange(other.base, nullptr);
+        mappedBytes = std::exchange(other.mappedBytes, 0);
+        isMapped = std::exchange(other.isMapped, false);
+        buffer = std::move(other.buffer);
+        header = std::exchange(other.header, nullptr);
+        control = std::exchange(other.control, nullptr);
+        hashes = std::exchange(other.hashes, nullptr);
+        keyEnds = std::exchange(other.keyEnds, nullptr);
+        values = std::exchange(other.values, nullptr);
+        arena = std::exchange(other.arena, nullptr);
+    }
+    return *this;
+}
+
+//----------------------------------------------------------------
+// HashTableSnapshot (destructor): Unmaps the file.
+//---------------------------------------------------------------
+HashTableSnapshot::~HashTableSnapshot() {
+    release();
+}
+
+//----------------------------------------------------------------
+// release: Unmaps the file or frees the buffer holding it.
+//    Returns:  void
+//---------------------------------------------------------------
+void HashTableSnapshot::release() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (isMapped) {
+        munmap(const_cast<char*>(base), mappedBytes);
+    }
+#endif
+    buffer.reset();
+    base = nullptr;
+    isMapped = false;
+}
+
+//----------------------------------------------------------------
+// keyAt: Returns the key stored in a bucket. Offsets out of range
+//             (possible only in a file opened without checksum)
+//             give an empty key instead of reading past the arena.
+//    Returns:  key (string_view)
+//    Parameters:
+//       index (size_t) - bucket index
+//---------------------------------------------------------------
+std::string_view HashTableSnapshot::keyAt(size_t index) const {
+    uint64_t start = index == 0 ? 0 : keyEnds[index - 1];
+    uint64_t end = keyEnds[index];
+    if (start > end || end > header->arenaBytes) {
+        return {};
+    }
+    return std::string_view(arena + start, end - start);
+}
+
+//----------------------------------------------------------------
+// findBucket: Finds a key with the probe sequence of the table
+//             that was saved. Robin Hood snapshots stop early like
+//             HashTable::findBucket() does.
+//    Returns:  bucket index if found, SIZE_MAX if not found (size_t)
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+size_t HashTableSnapshot::findBucket(std::string_view key) const {
+    size_t cap = header->capacity;
+    uint64_t hash = HashTable::hashWith(key, static_cast<HashPolicy>(header->hashPolicy));
+    uint8_t tag = HashTable::controlTag(hash);
+    size_t probeIdx = hash % cap;
+    size_t step = 0;
+    bool isRobinHood = header->probePolicy == static_cast<uint32_t>(ProbePolicy::ROBIN_HOOD);
+
+    for (size_t i = 0; i < cap; i++) {
+        uint8_t ctrl = control[probeIdx];
+        if (ctrl == tag && hashes[probeIdx] == hash && keyAt(probeIdx) == key) {
+            return probeIdx;
+        }
+        if (ctrl == HashTable::CTRL_EMPTY) {
+            break;
+        }
+        if (isRobinHood && ctrl < HashTable::CTRL_EMPTY) {
+            size_t home = hashes[probeIdx] % cap;
+            if ((probeIdx >= home ? probeIdx - home : probeIdx + cap - home) < i) {
+                break;
+            }
+        }
+        if (step == 0) {
+            step = isRobinHood ? 1 : HashTable::probeStepFor(hash, cap, header->probeSeed);
+        }
+        probeIdx += step;
+        if (probeIdx >= cap) {
+            probeIdx -= cap;
+        }
+    }
+    return SIZE_MAX;
+}
+
+//----------------------------------------------------------------
+// contains: Checks for a key in the snapshot.
+//    Returns:  true if key in snapshot, false otherwise (bool)
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+bool HashTableSnapshot::contains(std::string_view key) const {
+    return findBucket(key) != SIZE_MAX;
+}
+
+//----------------------------------------------------------------
+// get: Gets the value for a key in the snapshot.
+//    Returns:  value if found, std::nullopt if not found
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+std::optional<size_t> HashTableSnapshot::get(std::string_view key) const {
+    size_t bucketIdx = findBucket(key);
+    if (bucketIdx == SIZE_MAX) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(values[bucketIdx]);
+}
+
+//----------------------------------------------------------------
+// keys: Copies every key out of the snapshot.
+//    Returns:  vector of all keys (vector<string>)
+//---------------------------------------------------------------
+std::vector<std::string> HashTableSnapshot::keys() const {
+    std::vector<std::string> result;
+    result.reserve(header->size);
+    for (size_t i = 0; i < header->capacity; i++) {
+        if (control[i] < HashTable::CTRL_EMPTY) {
+            result.emplace_back(keyAt(i));
+        }
+    }
+    return result;
+}
+
+//----------------------------------------------------------------
+// size: Returns the number of key value pairs in the snapshot.
+//    Returns:  number of elements (size_t)
+//---------------------------------------------------------------
+size_t HashTableSnapshot::size() const {
+    return header->size;
+}
+
+//----------------------------------------------------------------
+// capacity: Returns the number of buckets in the snapshot.
+//    Returns:  capacity (size_t)
+//---------------------------------------------------------------
+size_t HashTableSnapshot::capacity() const {
+    return header->capacity;
+}
@@ -0,0 +1,106 @@
+/**
+ * HashTableSnapshot.h
+ *
+ * Read-only view of a table saved with HashTable::saveSnapshot().
+ * The file is memory-mapped and looked up in place: no parsing, no
+ * rehashing and no per-key allocation, so a table of any size is
+ * usable as soon as open() returns.
+ *
+ * File layout, version 1. Integers are fixed-width in the writer's
+ * byte order, which open() checks. Every section starts on an 8-byte
+ * boundary.
+ *
+ *   SnapshotHeader            64 bytes
+ *   control[capacity]         uint8_t, same encoding as HashTable
+ *   (padding to 8 bytes)
+ *   hashes[capacity]          uint64_t, cached hash per bucket
+ *   keyEnds[capacity]         uint64_t, end of bucket i's key in the
+ *                             arena; it starts at keyEnds[i - 1]
+ *   values[capacity]          uint64_t
+ *   arena[arenaBytes]         key bytes, in bucket order
+ *
+ * Buckets keep the index they had in the table, and the header
+ * records the hash policy, probe policy and probe seed, so lookups
+ * follow the same probe sequence as the table that was saved.
+ */
+#ifndef HASHTABLESNAPSHOT_H
+#define HASHTABLESNAPSHOT_H
+
+#include "HashTable.h"
+#include <memory>
+
+struct SnapshotHeader {
+    static constexpr char MAGIC[8] = {'H', 'T', 'S', 'N', 'A', 'P', '\0', '\0'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t capacity;
+    uint64_t size;
+    uint64_t probeSeed;
+    uint32_t hashPolicy;
+    uint32_t probePolicy;  // 0 (DOUBLE_HASH) in files written before Robin Hood tables
+    uint64_t arenaBytes;
+    uint64_t checksum;     // Over the header (with this field 0) and every section
+};
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header layout changed");
+
+class HashTableSnapshot {
+private:
+    // Section offsets for a snapshot of a given size
+    struct Layout {
+        size_t control;
+        size_t hashes;
+        size_t keyEnds;
+        size_t values;
+        size_t arena;
+        size_t total;
+    };
+
+    const char* base = nullptr;
+    size_t mappedBytes = 0;
+    bool isMapped = false;
+    std::unique_ptr<uint64_t[]> buffer;   // File contents when mmap is not available
+
+    const SnapshotHeader* header = nullptr;
+    const uint8_t* control = nullptr;
+    const uint64_t* hashes = nullptr;
+    const uint64_t* keyEnds = nullptr;
+    const uint64_t* values = nullptr;
+    const char* arena = nullptr;
+
+    HashTableSnapshot() = default;
+    static Layout layoutFor(uint64_t capacity, uint64_t arenaBytes);
+    static uint64_t checksumOf(const SnapshotHeader& header, const char* base, const Layout& layout);
+    bool mapFile(const std::string& path);
+    bool validateHeader() const;
+    bool verifyContents() const;
+    std::string_view keyAt(size_t index) const;
+    size_t findBucket(std::string_view key) const;
+    void release();
+
+    friend class HashTable;
+
+public:
+    // Maps a snapshot file. Returns nullopt if it cannot be read, is
+    // not a snapshot this build understands, or (when verifyChecksum
+    // is set) fails its checksum. Skipping the checksum avoids reading
+    // the whole file up front.
+    static std::optional<HashTableSnapshot> open(const std::string& path, bool verifyChecksum = true);
+
+    HashTableSnapshot(HashTableSnapshot&& other) noexcept;
+    HashTableSnapshot& operator=(HashTableSnapshot&& other) noexcept;
+    HashTableSnapshot(const HashTableSnapshot&) = delete;
+    HashTableSnapshot& operator=(const HashTableSnapshot&) = delete;
+    ~HashTableSnapshot();
+
+    bool contains(std::string_view key) const;
+    std::optional<size_t> get(std::string_view key) const;
+    std::vector<std::string> keys() const;
+    size_t size() const;
+    size_t capacity() const;
+};
+
+#endif
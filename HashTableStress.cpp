@@ -0,0 +1,152 @@
+/**
+ * HashTableStress.cpp
+ *
+ * Multi-threaded stress run for the thread-safe tables. Writer
+ * threads insert, remove and reassign keys (forcing resizes along
+ * the way) while reader threads look them up. Every key only ever
+ * holds one value, so a reader that sees anything else has read a
+ * torn or freed slot. Build with -DHASHTABLE_TSAN=ON to run it
+ * under ThreadSanitizer, and add -DHASHTABLE_STATS=ON to check the
+ * statistics counters as well.
+ *
+ * "HashTableStress [seconds]" runs each table for the given time
+ * (default 2) and exits non-zero if any check failed.
+ */
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include "ConcurrentHashTable.h"
+#include "OptimisticHashTable.h"
+
+using namespace std;
+
+//----------------------------------------------------------------
+// expectedValue: The only value a key is ever given.
+//    Returns:  value for key index i (size_t)
+//---------------------------------------------------------------
+size_t expectedValue(size_t i) {
+    return i * 7 + 1;
+}
+
+//----------------------------------------------------------------
+// runStress: Runs readers and writers against one table.
+//    Returns:  number of failed checks (size_t)
+//    Parameters:
+//       name (string) - label for the output
+//       readerCount (size_t) - lookup threads
+//       writerCount (size_t) - mutating threads
+//       seconds (double) - how long to run
+//---------------------------------------------------------------
+template <typename Table>
+size_t runStress(const string& name, size_t readerCount, size_t writerCount, double seconds) {
+    constexpr size_t KEYS = 20000;
+    vector<string> keys;
+    keys.reserve(KEYS);
+    for (size_t i = 0; i < KEYS; i++) {
+        keys.push_back("stress-key-" + to_string(i));
+    }
+
+    // Start small so the writers push the table through several resizes
+    Table table(1);
+    for (size_t i = 0; i < KEYS; i += 2) {
+        table.insert(keys[i], expectedValue(i));
+    }
+
+    atomic<bool> stop{false};
+    atomic<size_t> failures{0};
+    atomic<size_t> reads{0};
+    atomic<size_t> writes{0};
+    vector<thread> workers;
+
+    for (size_t t = 0; t < readerCount; t++) {
+        workers.emplace_back([&, t] {
+            mt19937_64 rng(t + 1);
+            size_t count = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                size_t i = rng() % KEYS;
+                optional<size_t> value = table.get(keys[i]);
+                if (value && *value != expectedValue(i)) {
+                    failures++;
+                }
+                count++;
+            }
+            reads += count;
+        });
+    }
+
+    for (size_t t = 0; t < writerCount; t++) {
+        workers.emplace_back([&, t] {
+            mt19937_64 rng(1000 + t);
+            size_t count = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                size_t i = rng() % KEYS;
+                switch (rng() % 3) {
+                case 0:
+                    table.insert(keys[i], expectedValue(i));
+                    break;
+                case 1:
+                    table.remove(keys[i]);
+                    break;
+                default:
+                    table.assign(keys[i], expectedValue(i));
+                    break;
+                }
+                count++;
+            }
+            writes += count;
+        });
+    }
+
+    this_thread::sleep_for(chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Whatever survived must still be readable with the right value
+    size_t found = 0;
+    for (size_t i = 0; i < KEYS; i++) {
+        optional<size_t> value = table.get(keys[i]);
+        if (value) {
+            found++;
+            if (*value != expectedValue(i)) {
+                failures++;
+            }
+        }
+    }
+    if (found != table.size() || table.keys().size() != found) {
+        failures++;
+    }
+
+    cout << name << ": " << reads.load() << " reads, " << writes.load() << " writes, "
+         << failures.load() << " failures" << endl;
+    return failures.load();
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? stod(argv[1]) : 2.0;
+    size_t hardware = max<size_t>(thread::hardware_concurrency(), 2);
+    size_t readerCount = hardware - 1;
+    // At least four readers, so readers race each other even on a
+    // machine with one or two cores
+    size_t manyReaders = max<size_t>(readerCount, 4);
+
+    size_t failures = 0;
+    failures += runStress<OptimisticHashTable>("OptimisticHashTable", readerCount, 1, seconds);
+    failures += runStress<OptimisticHashTable>("OptimisticHashTable (2 writers)", readerCount, 2, seconds);
+    failures += runStress<ConcurrentHashTable>("ConcurrentHashTable", readerCount, 2, seconds);
+    failures += runStress<OptimisticHashTable>("OptimisticHashTable (" + to_string(manyReaders) + " readers)",
+                                               manyReaders, 1, seconds);
+    failures += runStress<ConcurrentHashTable>("ConcurrentHashTable (" + to_string(manyReaders) + " readers)",
+                                               manyReaders, 1, seconds);
+    // More readers than OptimisticHashTable has reader slots (128), so
+    // some wait for a slot
+    failures += runStress<OptimisticHashTable>("OptimisticHashTable (160 readers)", 160, 1, seconds);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
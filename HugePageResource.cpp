@@ -0,0 +1,133 @@
+/**
+ * HugePageResource.cpp
+ * Memory resource that maps large allocations with huge pages
+ */
+#include "HugePageResource.h"
+#include <cstdint>
+#include <new>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+//----------------------------------------------------------------
+// roundToHugePage: Rounds a size up to whole huge pages.
+//    Returns:  bytes (size_t)
+//    Parameters:
+//       bytes (size_t) - size to round
+//---------------------------------------------------------------
+static size_t roundToHugePage(size_t bytes) {
+    return (bytes + HugePageResource::HUGE_PAGE_BYTES - 1) & ~(HugePageResource::HUGE_PAGE_BYTES - 1);
+}
+
+//----------------------------------------------------------------
+// HugePageResource (constructor): Creates the resource. Nothing is
+//             mapped until the first large allocation.
+//    Parameters:
+//       upstream (memory_resource*) - resource for small allocations
+//---------------------------------------------------------------
+HugePageResource::HugePageResource(std::pmr::memory_resource* upstream)
+    : upstream(upstream), mapped(0), reservedPages(true) {
+}
+
+//----------------------------------------------------------------
+// mappedBytes: Returns the bytes of huge page mappings currently
+//             held by allocations from this resource.
+//    Returns:  bytes (size_t)
+//---------------------------------------------------------------
+size_t HugePageResource::mappedBytes() const {
+    return mapped.load(std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------
+// usesReservedPages: Checks if new mappings still try reserved huge
+//             pages (MAP_HUGETLB). False once the system has had
+//             none to give, after which transparent huge pages are
+//             requested instead.
+//    Returns:  true if MAP_HUGETLB is still tried (bool)
+//---------------------------------------------------------------
+bool HugePageResource::usesReservedPages() const {
+    return reservedPages.load(std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------
+// do_allocate: Maps a large allocation with huge pages, or passes a
+//             small one upstream. A transparent huge page mapping is
+//             made one huge page too long and trimmed, so that it
+//             starts on a huge page boundary.
+//    Returns:  the memory (void*); throws bad_alloc if mmap fails,
+//             as memory_resource requires
+//    Parameters:
+//       bytes (size_t) - size requested
+//       alignment (size_t) - alignment requested
+//---------------------------------------------------------------
+void* HugePageResource::do_allocate(size_t bytes, size_t alignment) {
+#if defined(__unix__) || defined(__APPLE__)
+    if (bytes >= HUGE_PAGE_BYTES && alignment <= HUGE_PAGE_BYTES) {
+        size_t size = roundToHugePage(bytes);
+#ifdef MAP_HUGETLB
+        if (reservedPages.load(std::memory_order_relaxed)) {
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                mapped.fetch_add(size, std::memory_order_relaxed);
+                return p;
+            }
+            reservedPages.store(false, std::memory_order_relaxed);
+        }
+#endif
+        void* raw = mmap(nullptr, size + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        char* start = static_cast<char*>(raw);
+        char* aligned = reinterpret_cast<char*>(roundToHugePage(reinterpret_cast<uintptr_t>(start)));
+        if (aligned > start) {
+            munmap(start, static_cast<size_t>(aligned - start));
+        }
+        char* end = start + size + HUGE_PAGE_BYTES;
+        if (end > aligned + size) {
+            munmap(aligned + size, static_cast<size_t>(end - (aligned + size)));
+        }
+#ifdef MADV_HUGEPAGE
+        madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+        mapped.fetch_add(size, std::memory_order_relaxed);
+        return aligned;
+    }
+#endif
+    return upstream->allocate(bytes, alignment);
+}
+
+//----------------------------------------------------------------
+// do_deallocate: Unmaps a large allocation or passes a small one
+//             upstream; bytes and alignment pick the same path
+//             do_allocate() took.
+//    Returns:  void
+//    Parameters:
+//       p (void*) - memory from do_allocate()
+//       bytes (size_t) - size it was allocated with
+//       alignment (size_t) - alignment it was allocated with
+//---------------------------------------------------------------
+void HugePageResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+#if defined(__unix__) || defined(__APPLE__)
+    if (bytes >= HUGE_PAGE_BYTES && alignment <= HUGE_PAGE_BYTES) {
+        size_t size = roundToHugePage(bytes);
+        munmap(p, size);
+        mapped.fetch_sub(size, std::memory_order_relaxed);
+        return;
+    }
+#endif
+    upstream->deallocate(p, bytes, alignment);
+}
+
+//----------------------------------------------------------------
+// do_is_equal: Memory from one HugePageResource can only be freed
+//             by the same one.
+//    Returns:  true if other is this resource (bool)
+//    Parameters:
+//       other (const memory_resource&) - resource to compare
+//---------------------------------------------------------------
+bool HugePageResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
@@ -0,0 +1,49 @@
+/**
+ * HugePageResource.h
+ *
+ * A std::pmr::memory_resource that backs large allocations with huge
+ * pages, for big long-lived tables whose bucket arrays would
+ * otherwise take one TLB entry per 4 KiB page:
+ *
+ *   HugePageResource pages;
+ *   HashTable table(8, HashPolicy::MIX64, ResizeMode::STOP_THE_WORLD, 0, &pages);
+ *
+ * An allocation of at least HUGE_PAGE_BYTES is mapped on its own,
+ * rounded up to whole huge pages and aligned to one. Reserved huge
+ * pages (MAP_HUGETLB) are tried first; once that fails, mappings use
+ * normal pages and madvise(MADV_HUGEPAGE) asks for transparent huge
+ * pages instead. Smaller allocations, such as key arena chunks, go to
+ * the upstream resource. Where mmap is not available everything goes
+ * upstream.
+ *
+ * Safe to share between threads if the upstream resource is.
+ */
+#ifndef HUGEPAGERESOURCE_H
+#define HUGEPAGERESOURCE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+class HugePageResource : public std::pmr::memory_resource {
+public:
+    static constexpr size_t HUGE_PAGE_BYTES = size_t{2} << 20;
+
+    explicit HugePageResource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    HugePageResource(const HugePageResource&) = delete;
+    HugePageResource& operator=(const HugePageResource&) = delete;
+
+    size_t mappedBytes() const;
+    bool usesReservedPages() const;
+
+private:
+    std::pmr::memory_resource* upstream;
+    std::atomic<size_t> mapped;          // Bytes currently mapped by this resource
+    std::atomic<bool> reservedPages;     // False once MAP_HUGETLB has failed
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+#endif
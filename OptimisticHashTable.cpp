@@ -0,0 +1,443 @@
+/**
+ * OptimisticHashTable.cpp
+ * Hash table with lock-free optimistic reads
+ */
+#include "OptimisticHashTable.h"
+#include <thread>
+#include <limits>
+
+using namespace std;
+
+const OptimisticHashTable::KeyNode OptimisticHashTable::TOMBSTONE{0, ""};
+
+//----------------------------------------------------------------
+// SlotArray (constructor): Allocates capacity empty slots.
+//    Parameters:
+//       capacity (size_t) - number of slots, a power of two
+//---------------------------------------------------------------
+OptimisticHashTable::SlotArray::SlotArray(size_t capacity)
+    : capacity(capacity), slots(std::make_unique<Slot[]>(capacity)) {
+}
+
+//----------------------------------------------------------------
+// ReadGuard (constructor): Claims a free reader slot and records
+//             the current epoch in it. Each thread starts looking at
+//             the same slot every time, so the slot's cache line
+//             normally stays with that thread. If all MAX_READERS
+//             slots are taken, the thread yields after each full
+//             sweep so a preempted slot holder can run and finish.
+//    Parameters:
+//       table (const OptimisticHashTable&) - table about to be read
+//---------------------------------------------------------------
+OptimisticHashTable::ReadGuard::ReadGuard(const OptimisticHashTable& table) {
+    static thread_local size_t hint = std::hash<std::thread::id>{}(std::this_thread::get_id());
+
+    // The claim is seq_cst, like the reader's loads of the table and
+    // the writer's unlink and scan in reclaim(): either the writer
+    // sees this slot in use, or this reader sees the table after the
+    // unlink. No fence is needed, so ThreadSanitizer models it all.
+    size_t index = hint;
+    for (size_t tries = 1; ; tries++) {
+        ReaderSlot& candidate = table.readers[index % MAX_READERS];
+        uint64_t expected = 0;
+        uint64_t epoch = table.globalEpoch.load(memory_order_seq_cst);
+        if (candidate.epoch.compare_exchange_strong(expected, epoch, memory_order_seq_cst)) {
+            slot = &candidate;
+            break;
+        }
+        index++;
+        if (tries % MAX_READERS == 0) {
+            this_thread::yield();
+        }
+    }
+    hint = index;
+}
+
+//----------------------------------------------------------------
+// ReadGuard (destructor): Releases the reader slot.
+//---------------------------------------------------------------
+OptimisticHashTable::ReadGuard::~ReadGuard() {
+    slot->epoch.store(0, memory_order_release);
+}
+
+//----------------------------------------------------------------
+// OptimisticHashTable (constructor): Creates an empty table. The
+//             capacity is rounded up to a power of two.
+//    Parameters:
+//       initCapacity (size_t) - initial number of slots
+//---------------------------------------------------------------
+OptimisticHashTable::OptimisticHashTable(size_t initCapacity)
+    : readers(std::make_unique<ReaderSlot[]>(MAX_READERS)) {
+    size_t cap = 8;
+    while (cap < initCapacity) {
+        cap *= 2;
+    }
+    current.store(new SlotArray(cap), memory_order_relaxed);
+}
+
+//----------------------------------------------------------------
+// OptimisticHashTable (destructor): Frees the keys, the current
+//             array and everything still waiting to be reclaimed.
+//             No reader may be running.
+//---------------------------------------------------------------
+OptimisticHashTable::~OptimisticHashTable() {
+    SlotArray* array = current.load(memory_order_relaxed);
+    for (size_t i = 0; i < array->capacity; i++) {
+        const KeyNode* node = array->slots[i].node.load(memory_order_relaxed);
+        if (node != nullptr && node != &TOMBSTONE) {
+            delete node;
+        }
+    }
+    delete array;
+
+    for (auto& [epoch, node] : retiredNodes) {
+        delete node;
+    }
+    for (auto& [epoch, old] : retiredArrays) {
+        delete old;
+    }
+}
+
+//----------------------------------------------------------------
+// findSlot: Finds the slot holding a key. Only called by writers,
+//             which hold writeLock.
+//    Returns:  slot index, or SIZE_MAX if not found (size_t)
+//    Parameters:
+//       array (const SlotArray&) - array to search
+//       key (string_view) - the key to find
+//       hash (uint64_t) - hash of the key
+//---------------------------------------------------------------
+size_t OptimisticHashTable::findSlot(const SlotArray& array, std::string_view key, uint64_t hash) {
+    size_t mask = array.capacity - 1;
+    size_t index = hash & mask;
+    for (size_t i = 1; i <= array.capacity; i++) {
+        const KeyNode* node = array.slots[index].node.load(memory_order_relaxed);
+        if (node == nullptr) {
+            return SIZE_MAX;
+        }
+        if (node != &TOMBSTONE && node->hash == hash && node->key == key) {
+            return index;
+        }
+        index = (index + i) & mask;
+    }
+    return SIZE_MAX;
+}
+
+//----------------------------------------------------------------
+// findFreeSlot: Finds the first empty or removed slot on a hash's
+//             probe sequence.
+//    Returns:  slot index (size_t)
+//    Parameters:
+//       array (const SlotArray&) - array to search
+//       hash (uint64_t) - hash of the key being placed
+//---------------------------------------------------------------
+size_t OptimisticHashTable::findFreeSlot(const SlotArray& array, uint64_t hash) {
+    size_t mask = array.capacity - 1;
+    size_t index = hash & mask;
+    for (size_t i = 1; ; i++) {
+        const KeyNode* node = array.slots[index].node.load(memory_order_relaxed);
+        if (node == nullptr || node == &TOMBSTONE) {
+            return index;
+        }
+        index = (index + i) & mask;
+    }
+}
+
+//----------------------------------------------------------------
+// readValue: Lock-free lookup. Reads the slots between two loads
+//             of the sequence number and starts over if a writer
+//             ran in between, so a result is only returned if it
+//             matches one consistent state of the table. Slot fields
+//             are read with acquire: reading anything a writer stored
+//             then guarantees the second sequence load sees that
+//             writer's odd sequence number.
+//    Returns:  value if found, std::nullopt if not found
+//    Parameters:
+//       key (string_view) - the key to find
+//       hash (uint64_t) - hash of the key
+//---------------------------------------------------------------
+std::optional<size_t> OptimisticHashTable::readValue(std::string_view key, uint64_t hash) const {
+    ReadGuard guard(*this);
+
+    while (true) {
+        uint64_t before = sequence.load(memory_order_acquire);
+        if (before & 1) {
+            this_thread::yield();
+            continue;
+        }
+
+        const SlotArray* array = current.load(memory_order_seq_cst);
+        size_t mask = array->capacity - 1;
+        size_t index = hash & mask;
+        std::optional<size_t> result;
+        for (size_t i = 1; i <= array->capacity; i++) {
+            const Slot& slot = array->slots[index];
+            const KeyNode* node = slot.node.load(memory_order_seq_cst);
+            if (node == nullptr) {
+                break;
+            }
+            if (node != &TOMBSTONE && slot.hash.load(memory_order_acquire) == hash && node->key == key) {
+                result = slot.value.load(memory_order_acquire);
+                break;
+            }
+            index = (index + i) & mask;
+        }
+
+        if (sequence.load(memory_order_relaxed) == before) {
+            return result;
+        }
+    }
+}
+
+//----------------------------------------------------------------
+// beginWrite: Makes the sequence number odd so readers that
+//             overlap the write will retry. Every slot store inside
+//             the write is a release, which keeps it after this one.
+//    Returns:  sequence number before the write (uint64_t)
+//---------------------------------------------------------------
+uint64_t OptimisticHashTable::beginWrite() {
+    uint64_t seq = sequence.load(memory_order_relaxed);
+    sequence.store(seq + 1, memory_order_relaxed);
+    return seq;
+}
+
+//----------------------------------------------------------------
+// endWrite: Makes the sequence number even again, publishing the
+//             write.
+//    Returns:  void
+//    Parameters:
+//       seq (uint64_t) - value returned by beginWrite()
+//---------------------------------------------------------------
+void OptimisticHashTable::endWrite(uint64_t seq) {
+    sequence.store(seq + 2, memory_order_release);
+}
+
+//----------------------------------------------------------------
+// rehash: Copies the live keys into a new array and publishes it.
+//             Keys are moved by pointer, not copied. The old array
+//             is retired, since readers may still be probing it.
+//    Returns:  void
+//    Parameters:
+//       newCapacity (size_t) - slots in the new array, a power of two
+//---------------------------------------------------------------
+void OptimisticHashTable::rehash(size_t newCapacity) {
+    SlotArray* old = current.load(memory_order_relaxed);
+    SlotArray* fresh = new SlotArray(newCapacity);
+
+    for (size_t i = 0; i < old->capacity; i++) {
+        const Slot& from = old->slots[i];
+        const KeyNode* node = from.node.load(memory_order_relaxed);
+        if (node == nullptr || node == &TOMBSTONE) {
+            continue;
+        }
+        Slot& to = fresh->slots[findFreeSlot(*fresh, node->hash)];
+        to.hash.store(node->hash, memory_order_relaxed);
+        to.value.store(from.value.load(memory_order_relaxed), memory_order_relaxed);
+        to.node.store(node, memory_order_relaxed);
+    }
+
+    uint64_t seq = beginWrite();
+    current.store(fresh, memory_order_seq_cst);
+    endWrite(seq);
+
+    numRemoved = 0;
+    retiredArrays.emplace_back(globalEpoch.load(memory_order_seq_cst), old);
+    reclaim();
+}
+
+//----------------------------------------------------------------
+// reclaim: Advances the epoch and frees every retired key and
+//             array that was retired before the oldest epoch a
+//             reader is still in. The epoch bump and the scan of
+//             reader slots are seq_cst, pairing with ReadGuard.
+//    Returns:  void
+//---------------------------------------------------------------
+void OptimisticHashTable::reclaim() {
+    globalEpoch.fetch_add(1, memory_order_seq_cst);
+
+    uint64_t oldest = numeric_limits<uint64_t>::max();
+    for (size_t i = 0; i < MAX_READERS; i++) {
+        uint64_t epoch = readers[i].epoch.load(memory_order_seq_cst);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    erase_if(retiredNodes, [oldest](const auto& retired) {
+        if (retired.first < oldest) {
+            delete retired.second;
+            return true;
+        }
+        return false;
+    });
+    erase_if(retiredArrays, [oldest](const auto& retired) {
+        if (retired.first < oldest) {
+            delete retired.second;
+            return true;
+        }
+        return false;
+    });
+}
+
+//----------------------------------------------------------------
+// insert: Inserts a key value pair if the key is not already in
+//             the table. Grows the array once half its slots are
+//             used, counting removed slots. Rejects the reserved
+//             value 9999, like HashTable::insert().
+//    Returns:  true if inserted, false if duplicate or value is 9999 (bool)
+//    Parameters:
+//       key (string_view) - the key to insert
+//       value (size_t) - the value to associate with the key
+//---------------------------------------------------------------
+bool OptimisticHashTable::insert(std::string_view key, size_t value) {
+    if (value == 9999) {
+        return false;
+    }
+    uint64_t hash = hashMix64(key);
+    lock_guard guard(writeLock);
+
+    if (findSlot(*current.load(memory_order_relaxed), key, hash) != SIZE_MAX) {
+        return false;
+    }
+
+    size_t live = numElements.load(memory_order_relaxed);
+    size_t cap = current.load(memory_order_relaxed)->capacity;
+    if ((live + numRemoved + 1) * 2 > cap) {
+        // Mostly tombstones: rebuild at the same size instead of growing
+        rehash((live + 1) * 4 > cap ? cap * 2 : cap);
+    }
+
+    SlotArray* array = current.load(memory_order_relaxed);
+    size_t index = findFreeSlot(*array, hash);
+    Slot& slot = array->slots[index];
+    if (slot.node.load(memory_order_relaxed) == &TOMBSTONE) {
+        numRemoved--;
+    }
+
+    const KeyNode* node = new KeyNode{hash, std::string(key)};
+    uint64_t seq = beginWrite();
+    slot.hash.store(hash, memory_order_release);
+    slot.value.store(value, memory_order_release);
+    slot.node.store(node, memory_order_release);
+    endWrite(seq);
+
+    numElements.store(live + 1, memory_order_relaxed);
+    return true;
+}
+
+//----------------------------------------------------------------
+// remove: Removes a key. Its node is retired rather than freed,
+//             since a reader may be comparing against it.
+//    Returns:  true if removed, false if key not found (bool)
+//    Parameters:
+//       key (string_view) - the key to remove
+//---------------------------------------------------------------
+bool OptimisticHashTable::remove(std::string_view key) {
+    uint64_t hash = hashMix64(key);
+    lock_guard guard(writeLock);
+
+    SlotArray* array = current.load(memory_order_relaxed);
+    size_t index = findSlot(*array, key, hash);
+    if (index == SIZE_MAX) {
+        return false;
+    }
+
+    Slot& slot = array->slots[index];
+    const KeyNode* node = slot.node.load(memory_order_relaxed);
+    uint64_t seq = beginWrite();
+    slot.node.store(&TOMBSTONE, memory_order_seq_cst);
+    endWrite(seq);
+
+    numElements.store(numElements.load(memory_order_relaxed) - 1, memory_order_relaxed);
+    numRemoved++;
+    retiredNodes.emplace_back(globalEpoch.load(memory_order_seq_cst), node);
+    if (retiredNodes.size() >= RECLAIM_BATCH) {
+        reclaim();
+    }
+    return true;
+}
+
+//----------------------------------------------------------------
+// contains: Checks for a key without locking.
+//    Returns:  true if key in table, false otherwise (bool)
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+bool OptimisticHashTable::contains(std::string_view key) const {
+    return readValue(key, hashMix64(key)).has_value();
+}
+
+//----------------------------------------------------------------
+// get: Gets the value for a key without locking.
+//    Returns:  value if found, std::nullopt if not found
+//    Parameters:
+//       key (string_view) - the key to search for
+//---------------------------------------------------------------
+std::optional<size_t> OptimisticHashTable::get(std::string_view key) const {
+    return readValue(key, hashMix64(key));
+}
+
+//----------------------------------------------------------------
+// assign: Replaces the value of an existing key, unless the new
+//             value is the reserved 9999.
+//    Returns:  true if the key was found, false if not or value is 9999 (bool)
+//    Parameters:
+//       key (string_view) - the key to update
+//       value (size_t) - the new value
+//---------------------------------------------------------------
+bool OptimisticHashTable::assign(std::string_view key, size_t value) {
+    if (value == 9999) {
+        return false;
+    }
+    uint64_t hash = hashMix64(key);
+    lock_guard guard(writeLock);
+
+    SlotArray* array = current.load(memory_order_relaxed);
+    size_t index = findSlot(*array, key, hash);
+    if (index == SIZE_MAX) {
+        return false;
+    }
+
+    uint64_t seq = beginWrite();
+    array->slots[index].value.store(value, memory_order_release);
+    endWrite(seq);
+    return true;
+}
+
+//----------------------------------------------------------------
+// keys: Collects every key. Takes the write lock, so the result
+//             is a consistent snapshot.
+//    Returns:  vector of all keys (vector<string>)
+//---------------------------------------------------------------
+std::vector<std::string> OptimisticHashTable::keys() {
+    lock_guard guard(writeLock);
+    std::vector<std::string> result;
+    result.reserve(numElements.load(memory_order_relaxed));
+
+    const SlotArray* array = current.load(memory_order_relaxed);
+    for (size_t i = 0; i < array->capacity; i++) {
+        const KeyNode* node = array->slots[i].node.load(memory_order_relaxed);
+        if (node != nullptr && node != &TOMBSTONE) {
+            result.push_back(node->key);
+        }
+    }
+    return result;
+}
+
+//----------------------------------------------------------------
+// size: Returns the number of keys. May be stale by the time the
+//             caller reads it.
+//    Returns:  number of key value pairs (size_t)
+//---------------------------------------------------------------
+size_t OptimisticHashTable::size() const {
+    return numElements.load(memory_order_relaxed);
+}
+
+//----------------------------------------------------------------
+// capacity: Returns the number of slots in the current array.
+//    Returns:  number of slots (size_t)
+//---------------------------------------------------------------
+size_t OptimisticHashTable::capacity() {
+    lock_guard guard(writeLock);
+    return current.load(memory_order_relaxed)->capacity;
+}
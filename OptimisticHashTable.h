@@ -0,0 +1,102 @@
+/**
+ * OptimisticHashTable.h
+ *
+ * Thread-safe hash table for read-mostly workloads. Readers take no
+ * lock: a lookup reads the table optimistically and retries if the
+ * table's sequence number changed while it was reading. Writers take
+ * one mutex. Removed keys and replaced arrays are freed only once no
+ * reader can still be looking at them (epoch-based reclamation), so a
+ * resize publishes a new array while old readers finish on the old one.
+ *
+ * A reader writes only its own reader slot, one cache line per slot,
+ * and never the lock word or the table itself. Use ConcurrentHashTable
+ * when writes are frequent.
+ */
+#ifndef OPTIMISTICHASHTABLE_H
+#define OPTIMISTICHASHTABLE_H
+
+#include "HashTable.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+class OptimisticHashTable {
+private:
+    // KeyNode holds one key. It is never changed once published, so
+    // readers can compare against it while a writer runs.
+    struct KeyNode {
+        uint64_t hash;
+        std::string key;
+    };
+
+    // Slot fields are atomics so a read racing a write is well
+    // defined; the sequence check throws away anything inconsistent.
+    struct Slot {
+        std::atomic<uint64_t> hash{0};
+        std::atomic<const KeyNode*> node{nullptr};   // nullptr if empty, &TOMBSTONE if removed
+        std::atomic<size_t> value{0};
+    };
+
+    struct SlotArray {
+        size_t capacity;   // Power of two
+        std::unique_ptr<Slot[]> slots;
+        explicit SlotArray(size_t capacity);
+    };
+
+    // ReaderSlot holds the epoch a reader entered at, 0 if unused
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0};
+    };
+
+    // ReadGuard claims a reader slot for the length of one lookup
+    class ReadGuard {
+    private:
+        ReaderSlot* slot;
+    public:
+        explicit ReadGuard(const OptimisticHashTable& table);
+        ~ReadGuard();
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+    };
+
+    static constexpr size_t MAX_READERS = 128;
+    static constexpr size_t RECLAIM_BATCH = 64;   // Retired keys collected before a reclaim pass
+    static const KeyNode TOMBSTONE;
+
+    std::atomic<SlotArray*> current;
+    alignas(64) std::atomic<uint64_t> sequence{0};   // Odd while a writer is changing the table
+    alignas(64) std::atomic<uint64_t> globalEpoch{1};
+    std::unique_ptr<ReaderSlot[]> readers;
+
+    // Writer-only state, guarded by writeLock
+    std::mutex writeLock;
+    std::atomic<size_t> numElements{0};
+    size_t numRemoved = 0;
+    std::vector<std::pair<uint64_t, const KeyNode*>> retiredNodes;
+    std::vector<std::pair<uint64_t, SlotArray*>> retiredArrays;
+
+    static size_t findSlot(const SlotArray& array, std::string_view key, uint64_t hash);
+    static size_t findFreeSlot(const SlotArray& array, uint64_t hash);
+    std::optional<size_t> readValue(std::string_view key, uint64_t hash) const;
+    uint64_t beginWrite();
+    void endWrite(uint64_t seq);
+    void rehash(size_t newCapacity);
+    void reclaim();
+
+public:
+    explicit OptimisticHashTable(size_t initCapacity = HashTable::DEFAULT_INITIAL_CAPACITY);
+    ~OptimisticHashTable();
+    OptimisticHashTable(const OptimisticHashTable&) = delete;
+    OptimisticHashTable& operator=(const OptimisticHashTable&) = delete;
+
+    bool insert(std::string_view key, size_t value);
+    bool remove(std::string_view key);
+    bool contains(std::string_view key) const;
+    std::optional<size_t> get(std::string_view key) const;
+    bool assign(std::string_view key, size_t value);
+    std::vector<std::string> keys();
+    size_t size() const;
+    size_t capacity();
+};
+
+#endif